@@ -0,0 +1,44 @@
+option(LIFE_BUILD_TESTS "Build the differential tests of the step kernels" ON)
+option(LIFE_BUILD_FUZZER "Build the kernel fuzzer, which needs Clang and libFuzzer" OFF)
+
+# Everything the kernels, the engine and the headless mode need, without the window.
+set(
+  LifeEngineSources
+
+  ${PROJECT_SOURCE_DIR}/life/Census.cpp
+  ${PROJECT_SOURCE_DIR}/life/Checkpoint.cpp
+  ${PROJECT_SOURCE_DIR}/life/Distributed.cpp
+  ${PROJECT_SOURCE_DIR}/life/Kernels.cpp
+  ${PROJECT_SOURCE_DIR}/life/PerfCounters.cpp
+  ${PROJECT_SOURCE_DIR}/life/Placement.cpp
+  ${PROJECT_SOURCE_DIR}/life/Rendering.cpp
+  ${PROJECT_SOURCE_DIR}/life/SharedWorld.cpp
+  ${PROJECT_SOURCE_DIR}/life/Simulation.cpp
+  ${PROJECT_SOURCE_DIR}/life/Stream.cpp
+  ${PROJECT_SOURCE_DIR}/life/Trace.cpp
+  ${PROJECT_SOURCE_DIR}/life/WorldBuffer.cpp
+)
+
+if(LIFE_BUILD_TESTS)
+  enable_testing()
+
+  add_executable(kernel_tests ${PROJECT_SOURCE_DIR}/tests/KernelTests.cpp ${LifeEngineSources})
+
+  target_include_directories(kernel_tests PRIVATE ${PROJECT_SOURCE_DIR}/life ${PROJECT_SOURCE_DIR}/tests)
+  target_compile_features(kernel_tests PRIVATE cxx_std_23)
+  target_compile_options(kernel_tests PRIVATE ${CompilerFlags})
+  target_link_options(kernel_tests PRIVATE ${LinkerFlags})
+  target_link_libraries(kernel_tests PRIVATE fmt::fmt)
+
+  add_test(NAME kernel_tests COMMAND kernel_tests)
+endif()
+
+if(LIFE_BUILD_FUZZER)
+  add_executable(kernel_fuzz ${PROJECT_SOURCE_DIR}/tests/KernelFuzz.cpp ${LifeEngineSources})
+
+  target_include_directories(kernel_fuzz PRIVATE ${PROJECT_SOURCE_DIR}/life ${PROJECT_SOURCE_DIR}/tests)
+  target_compile_features(kernel_fuzz PRIVATE cxx_std_23)
+  target_compile_options(kernel_fuzz PRIVATE ${CompilerFlags} "-fsanitize=fuzzer,address,undefined")
+  target_link_options(kernel_fuzz PRIVATE "-fsanitize=fuzzer,address,undefined")
+  target_link_libraries(kernel_fuzz PRIVATE fmt::fmt)
+endif()
@@ -1,12 +1,20 @@
 #ifndef LIFE_CAMERA_HPP
 #define LIFE_CAMERA_HPP
 
+#include <cstdint>
+
 namespace life 
 {
     struct Camera
     {
         float x, y, w, h;
     };
+
+    // The cells a camera covers, clamped to the edges of the world.
+    struct CellRect
+    {
+        uint64_t x, y, w, h;
+    };
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef LIFE_CELL_HPP
+#define LIFE_CELL_HPP
+
+#include <cstdint>
+
+namespace life
+{
+    enum class CellState : uint8_t { Dead = 0u, Alive };
+
+    // Coordinates of a cell in the world.
+    struct CellPosition
+    {
+        uint64_t x, y;
+    };
+}
+
+#endif
\ No newline at end of file
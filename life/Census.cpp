@@ -0,0 +1,591 @@
+#include <Census.hpp>
+#include <algorithm>
+#include <array>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <fmt/format.h>
+
+namespace life
+{
+	// Cell coordinates relative to an object, used while encoding and evolving it in isolation.
+	struct Offset
+	{
+		int64_t x, y;
+
+		bool operator==(const Offset&) const = default;
+	};
+
+	using Shape = std::vector<Offset>;
+
+	// Longest period searched for when classifying an object.
+	constexpr auto maxPeriod = 64;
+
+	// Moves the shape so that its bounding box starts at (0, 0) and sorts its cells in row order.
+	// Returns the translation that was applied.
+	static Offset normalize(Shape& shape)
+	{
+		Offset origin{ .x=std::numeric_limits<int64_t>::max(), .y=std::numeric_limits<int64_t>::max() };
+
+		for(const auto& cell : shape)
+		{
+			origin.x = std::min(origin.x, cell.x);
+			origin.y = std::min(origin.y, cell.y);
+		}
+
+		for(auto& cell : shape)
+		{
+			cell.x -= origin.x;
+			cell.y -= origin.y;
+		}
+
+		std::ranges::sort(shape, [](const Offset& a, const Offset& b){ return (a.y == b.y) ? a.x < b.x : a.y < b.y; });
+
+		return origin;
+	}
+
+	// Extended Wechsler encoding of one orientation of a shape, as used by apgsearch.
+	static std::string wechsler(Shape shape)
+	{
+		static constexpr std::string_view digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+		normalize(shape);
+
+		int64_t width = 0, height = 0;
+		for(const auto& cell : shape)
+		{
+			width = std::max(width, cell.x + 1);
+			height = std::max(height, cell.y + 1);
+		}
+
+		const auto strips = (height + 4) / 5;
+		std::vector<uint8_t> columns(static_cast<std::size_t>(width * strips));
+
+		for(const auto& cell : shape)
+		{
+			columns[static_cast<std::size_t>(((cell.y / 5) * width) + cell.x)] |= static_cast<uint8_t>(1u << (cell.y % 5));
+		}
+
+		std::string result;
+
+		for(auto strip = 0z; strip < strips; ++strip)
+		{
+			if(strip != 0) { result += 'z'; }
+
+			auto zeroes = 0uz;
+			for(auto x = 0z; x < width; ++x)
+			{
+				const auto value = columns[static_cast<std::size_t>((strip * width) + x)];
+				if(value == 0u)
+				{
+					++zeroes;
+					continue;
+				}
+
+				// Runs of empty columns are compressed, trailing ones are dropped entirely.
+				for(; zeroes > 39uz; zeroes -= 39uz) { result += "yz"; }
+				if(zeroes == 1uz) { result += '0'; }
+				else if(zeroes == 2uz) { result += 'w'; }
+				else if(zeroes == 3uz) { result += 'x'; }
+				else if(zeroes > 3uz) { result += 'y'; result += digits[zeroes - 4uz]; }
+				zeroes = 0uz;
+
+				result += digits[value];
+			}
+		}
+
+		return result;
+	}
+
+	// apgsearch prefers the shortest representation, then the lexicographically smallest.
+	static bool preferred(const std::string& a, const std::string& b)
+	{
+		return (a.size() == b.size()) ? a < b : a.size() < b.size();
+	}
+
+	// The encoding of a shape that is independent of its rotation and reflection.
+	static std::string canonicalCode(const Shape& shape)
+	{
+		std::string best;
+
+		for(auto orientation = 0u; orientation < 8u; ++orientation)
+		{
+			Shape transformed = shape;
+			for(auto& cell : transformed)
+			{
+				if((orientation & 4u) != 0u) { std::swap(cell.x, cell.y); }
+				if((orientation & 1u) != 0u) { cell.x = -cell.x; }
+				if((orientation & 2u) != 0u) { cell.y = -cell.y; }
+			}
+
+			auto code = wechsler(std::move(transformed));
+			if(best.empty() || preferred(code, best)) { best = std::move(code); }
+		}
+
+		return best;
+	}
+
+	// Advances a normalized shape by one generation on an unbounded plane.
+	static Shape evolve(const Shape& shape)
+	{
+		int64_t width = 0, height = 0;
+		for(const auto& cell : shape)
+		{
+			width = std::max(width, cell.x + 1);
+			height = std::max(height, cell.y + 1);
+		}
+
+		// One cell of margin on every side is all a single generation can grow into.
+		const auto gridW = width + 4, gridH = height + 4;
+		std::vector<uint8_t> grid(static_cast<std::size_t>(gridW * gridH));
+
+		for(const auto& cell : shape)
+		{
+			grid[static_cast<std::size_t>(((cell.y + 2) * gridW) + cell.x + 2)] = 1u;
+		}
+
+		Shape next;
+		for(auto y = 1z; y < gridH - 1; ++y)
+		{
+			for(auto x = 1z; x < gridW - 1; ++x)
+			{
+				auto neighbors = 0u;
+				for(auto dy = -1z; dy <= 1; ++dy)
+				{
+					for(auto dx = -1z; dx <= 1; ++dx)
+					{
+						if(dx != 0 || dy != 0) { neighbors += grid[static_cast<std::size_t>(((y + dy) * gridW) + x + dx)]; }
+					}
+				}
+
+				const bool alive = grid[static_cast<std::size_t>((y * gridW) + x)] != 0u;
+				if(neighbors == 3u || (alive && neighbors == 2u))
+				{
+					next.push_back(Offset{ .x=x - 2, .y=y - 2 });
+				}
+			}
+		}
+
+		return next;
+	}
+
+	// Runs the shape in isolation until it repeats and returns its apgcode: xs<population> for still
+	// lifes, xp<period> for oscillators and xq<period> for spaceships, encoded by the smallest phase.
+	static std::string classify(Shape shape)
+	{
+		normalize(shape);
+
+		const Shape start = shape;
+		auto best = canonicalCode(shape);
+		Offset displacement{};
+
+		for(auto period = 1; period <= maxPeriod; ++period)
+		{
+			shape = evolve(shape);
+			if(shape.empty() || shape.size() > censusMaxObjectCells) { break; }
+
+			const auto origin = normalize(shape);
+			displacement.x += origin.x;
+			displacement.y += origin.y;
+
+			if(shape == start)
+			{
+				if(displacement != Offset{}) { return "xq" + std::to_string(period) + '_' + best; }
+				if(period == 1) { return "xs" + std::to_string(start.size()) + '_' + best; }
+				return "xp" + std::to_string(period) + '_' + best;
+			}
+
+			auto code = canonicalCode(shape);
+			if(preferred(code, best)) { best = std::move(code); }
+		}
+
+		// The object does not survive on its own, so it is reported by the shape it had.
+		return "zz_" + canonicalCode(start);
+	}
+
+	// Names of the most common objects, keyed by their apgcode.
+	static const std::unordered_map<std::string, std::string_view>& catalogue()
+	{
+		static const auto names = []()
+		{
+			constexpr std::array<std::pair<std::string_view, std::array<std::string_view, 4>>, 10> patterns
+			{{
+				{ "block", { "oo", "oo" } },
+				{ "beehive", { ".oo.", "o..o", ".oo." } },
+				{ "loaf", { ".oo.", "o..o", ".o.o", "..o." } },
+				{ "boat", { "oo.", "o.o", ".o." } },
+				{ "ship", { "oo.", "o.o", ".oo" } },
+				{ "tub", { ".o.", "o.o", ".o." } },
+				{ "pond", { ".oo.", "o..o", "o..o", ".oo." } },
+				{ "blinker", { "ooo" } },
+				{ "glider", { ".o.", "..o", "ooo" } },
+				{ "lightweight spaceship", { ".o..o", "o....", "o...o", "oooo." } },
+			}};
+
+			std::unordered_map<std::string, std::string_view> result;
+
+			for(const auto& [name, rows] : patterns)
+			{
+				Shape shape;
+				for(auto y = 0uz; y < rows.size(); ++y)
+				{
+					for(auto x = 0uz; x < rows[y].size(); ++x)
+					{
+						if(rows[y][x] == 'o') { shape.push_back(Offset{ .x=static_cast<int64_t>(x), .y=static_cast<int64_t>(y) }); }
+					}
+				}
+
+				result.emplace(classify(std::move(shape)), name);
+			}
+
+			return result;
+		}();
+
+		return names;
+	}
+
+	// Part of a component found while labelling a band.
+	struct Fragment
+	{
+		uint32_t parent{};
+		uint64_t population{};
+		bool touchesTop = false, touchesBottom = false, oversized = false;
+
+		// Once oversized, only the cells in the band's boundary rows are kept.
+		std::vector<CellPosition> cells;
+	};
+
+	struct Tally
+	{
+		uint64_t count{};
+		Shape sample;
+	};
+
+	using TallyMap = std::unordered_map<std::string, Tally>;
+
+	struct BandCensus
+	{
+		TallyMap shapes;
+		std::vector<Fragment> boundary;
+		uint64_t objects{}, oversized{}, population{};
+	};
+
+	static Shape toShape(const std::vector<CellPosition>& cells)
+	{
+		Shape shape;
+		shape.reserve(cells.size());
+
+		for(const auto& cell : cells)
+		{
+			shape.push_back(Offset{ .x=static_cast<int64_t>(cell.x), .y=static_cast<int64_t>(cell.y) });
+		}
+
+		normalize(shape);
+		return shape;
+	}
+
+	// Shapes are tallied by their orientation-independent code; phases are merged after classification.
+	static void record(TallyMap& shapes, Shape shape)
+	{
+		auto& tally = shapes[canonicalCode(shape)];
+
+		if(tally.count++ == 0u) { tally.sample = std::move(shape); }
+	}
+
+	// Labels rows [first, last) one row at a time, using union-find over the fragments that
+	// reach the row above. Only those fragments are kept alive, so memory stays O(width).
+	static BandCensus labelBand(std::span<const CellState> world, uint64_t width, uint64_t height, uint64_t first, uint64_t last)
+	{
+		BandCensus band;
+
+		std::vector<Fragment> fragments(1), compacted;	// Label 0 means "no fragment".
+		std::vector<uint32_t> above(width), current(width), remap;
+
+		const auto onBoundary = [=](uint64_t y) { return (y == first && first > 0u) || (y + 1u == last && last < height); };
+
+		const auto find = [&fragments](uint32_t label)
+		{
+			while(fragments[label].parent != label)
+			{
+				fragments[label].parent = fragments[fragments[label].parent].parent;
+				label = fragments[label].parent;
+			}
+			return label;
+		};
+
+		const auto prune = [&onBoundary](Fragment& fragment, std::size_t from)
+		{
+			fragment.oversized = true;
+
+			const auto interior = std::ranges::remove_if(fragment.cells.begin() + static_cast<std::ptrdiff_t>(from), fragment.cells.end(),
+				[&onBoundary](const CellPosition& c){ return !onBoundary(c.y); });
+			fragment.cells.erase(interior.begin(), interior.end());
+		};
+
+		const auto unite = [&](uint32_t a, uint32_t b)
+		{
+			if(fragments[a].cells.size() < fragments[b].cells.size()) { std::swap(a, b); }
+
+			auto& into = fragments[a];
+			auto& from = fragments[b];
+			const auto appended = into.cells.size();
+
+			from.parent = a;
+			into.population += from.population;
+			into.touchesTop = into.touchesTop || from.touchesTop;
+			into.touchesBottom = into.touchesBottom || from.touchesBottom;
+			into.cells.insert(into.cells.end(), from.cells.cbegin(), from.cells.cend());
+			from.cells = {};
+
+			if(into.oversized || from.oversized || into.population > censusMaxObjectCells)
+			{
+				prune(into, into.oversized ? appended : 0uz);
+			}
+
+			return a;
+		};
+
+		const auto finish = [&](Fragment&& fragment)
+		{
+			band.population += fragment.population;
+
+			if(fragment.touchesTop || fragment.touchesBottom)
+			{
+				band.boundary.push_back(std::move(fragment));
+				return;
+			}
+
+			++band.objects;
+			if(fragment.oversized) { ++band.oversized; }
+			else { record(band.shapes, toShape(fragment.cells)); }
+		};
+
+		for(auto y = first; y < last; ++y)
+		{
+			const auto row = world.subspan(y * width, width);
+			std::ranges::fill(current, 0u);
+
+			for(auto x = 0uz; x < width; ++x)
+			{
+				if(row[x] != CellState::Alive) { continue; }
+
+				uint32_t root = 0u;
+				const auto join = [&](uint32_t label)
+				{
+					if(label == 0u) { return; }
+					label = find(label);
+					root = (root == 0u || root == label) ? label : unite(root, label);
+				};
+
+				if(x > 0uz) { join(current[x - 1uz]); join(above[x - 1uz]); }
+				join(above[x]);
+				if(x + 1uz < width) { join(above[x + 1uz]); }
+
+				if(root == 0u)
+				{
+					root = static_cast<uint32_t>(fragments.size());
+					fragments.emplace_back().parent = root;
+				}
+
+				auto& fragment = fragments[root];
+				++fragment.population;
+				if(y == first && first > 0u) { fragment.touchesTop = true; }
+				if(y + 1u == last && last < height) { fragment.touchesBottom = true; }
+
+				if(!fragment.oversized || onBoundary(y))
+				{
+					fragment.cells.push_back(CellPosition{ .x=x, .y=y });
+					if(!fragment.oversized && fragment.population > censusMaxObjectCells) { prune(fragment, 0uz); }
+				}
+
+				current[x] = root;
+			}
+
+			// Keep only the fragments that reach this row; everything else is a finished component.
+			remap.assign(fragments.size(), 0u);
+			compacted.clear();
+			compacted.emplace_back();
+
+			for(auto& label : current)
+			{
+				if(label == 0u) { continue; }
+
+				const auto root = find(label);
+				if(remap[root] == 0u)
+				{
+					remap[root] = static_cast<uint32_t>(compacted.size());
+					compacted.push_back(std::move(fragments[root]));
+					compacted.back().parent = remap[root];
+				}
+				label = remap[root];
+			}
+
+			for(auto i = 1uz; i < fragments.size(); ++i)
+			{
+				if(fragments[i].parent == i && remap[i] == 0u) { finish(std::move(fragments[i])); }
+			}
+
+			std::swap(fragments, compacted);
+			std::swap(above, current);
+		}
+
+		for(auto i = 1uz; i < fragments.size(); ++i)
+		{
+			finish(std::move(fragments[i]));
+		}
+
+		return band;
+	}
+
+	// Joins the fragments that continue across band boundaries and records the resulting objects.
+	static void stitchBands(std::vector<BandCensus>& bands, const std::vector<uint64_t>& edges, uint64_t width, BandCensus& into)
+	{
+		constexpr auto none = std::numeric_limits<std::size_t>::max();
+
+		std::vector<Fragment*> fragments;
+		std::vector<std::size_t> bandStart;
+
+		for(auto& band : bands)
+		{
+			bandStart.push_back(fragments.size());
+			for(auto& fragment : band.boundary) { fragments.push_back(&fragment); }
+		}
+		bandStart.push_back(fragments.size());
+
+		std::vector<std::size_t> parent(fragments.size());
+		std::iota(parent.begin(), parent.end(), 0uz);
+
+		const auto find = [&parent](std::size_t i)
+		{
+			while(parent[i] != i) { i = parent[i] = parent[parent[i]]; }
+			return i;
+		};
+
+		std::vector<std::size_t> owner(width);
+
+		for(auto b = 0uz; b + 1uz < bands.size(); ++b)
+		{
+			const auto lowerRow = edges[b + 1uz];
+			std::ranges::fill(owner, none);
+
+			for(auto i = bandStart[b + 1uz]; i < bandStart[b + 2uz]; ++i)
+			{
+				for(const auto& cell : fragments[i]->cells)
+				{
+					if(cell.y == lowerRow) { owner[cell.x] = i; }
+				}
+			}
+
+			for(auto i = bandStart[b]; i < bandStart[b + 1uz]; ++i)
+			{
+				for(const auto& cell : fragments[i]->cells)
+				{
+					if(cell.y + 1u != lowerRow) { continue; }
+
+					for(auto x = (cell.x > 0u) ? cell.x - 1u : 0u; x <= cell.x + 1u && x < width; ++x)
+					{
+						if(owner[x] != none) { parent[find(owner[x])] = find(i); }
+					}
+				}
+			}
+		}
+
+		std::unordered_map<std::size_t, Fragment> objects;
+
+		for(auto i = 0uz; i < fragments.size(); ++i)
+		{
+			auto& object = objects[find(i)];
+			object.population += fragments[i]->population;
+			object.oversized = object.oversized || fragments[i]->oversized;
+			object.cells.insert(object.cells.end(), fragments[i]->cells.cbegin(), fragments[i]->cells.cend());
+		}
+
+		for(auto& [root, object] : objects)
+		{
+			++into.objects;
+			if(object.oversized || object.population > censusMaxObjectCells) { ++into.oversized; }
+			else { record(into.shapes, toShape(object.cells)); }
+		}
+	}
+
+	CensusResult takeCensus(std::span<const CellState> world, uint64_t width, uint64_t height, std::size_t numBands)
+	{
+		numBands = std::clamp(numBands, 1uz, std::max(height, uint64_t{1}));
+
+		std::vector<uint64_t> edges(numBands + 1uz);
+		for(auto i = 0uz; i <= numBands; ++i) { edges[i] = (height * i) / numBands; }
+
+		std::vector<std::size_t> indices(numBands);
+		std::iota(indices.begin(), indices.end(), 0uz);
+
+		std::vector<BandCensus> bands(numBands);
+		std::for_each(std::execution::par, indices.cbegin(), indices.cend(),
+		[&](std::size_t i)
+		{
+			bands[i] = labelBand(world, width, height, edges[i], edges[i + 1uz]);
+		});
+
+		BandCensus total;
+		stitchBands(bands, edges, width, total);
+
+		for(auto& band : bands)
+		{
+			total.objects += band.objects;
+			total.oversized += band.oversized;
+			total.population += band.population;
+
+			for(auto& [code, tally] : band.shapes)
+			{
+				auto& merged = total.shapes[code];
+				if(merged.count == 0u) { merged.sample = std::move(tally.sample); }
+				merged.count += tally.count;
+			}
+		}
+
+		// Each distinct shape is classified once, so this costs nothing compared to labelling.
+		std::vector<std::pair<const std::string, Tally>*> distinct;
+		for(auto& entry : total.shapes) { distinct.push_back(&entry); }
+
+		std::vector<std::string> codes(distinct.size());
+		indices.resize(distinct.size());
+		std::iota(indices.begin(), indices.end(), 0uz);
+
+		std::for_each(std::execution::par, indices.cbegin(), indices.cend(),
+		[&](std::size_t i)
+		{
+			codes[i] = classify(distinct[i]->second.sample);
+		});
+
+		// Different phases of an oscillator or spaceship share one apgcode.
+		std::unordered_map<std::string, uint64_t> counts;
+		for(auto i = 0uz; i < distinct.size(); ++i)
+		{
+			counts[codes[i]] += distinct[i]->second.count;
+		}
+
+		CensusResult result{ .entries={}, .objects=total.objects, .oversized=total.oversized, .population=total.population };
+
+		const auto& names = catalogue();
+		for(auto& [code, count] : counts)
+		{
+			const auto name = names.find(code);
+			result.entries.push_back(CensusEntry{ .code=code, .name=(name != names.cend()) ? name->second : std::string_view{}, .count=count });
+		}
+
+		std::ranges::sort(result.entries, [](const CensusEntry& a, const CensusEntry& b){ return (a.count == b.count) ? a.code < b.code : a.count > b.count; });
+
+		return result;
+	}
+
+	void printCensus(std::FILE* out, uint64_t number, const CensusResult& census)
+	{
+		fmt::println(out, "Census of generation {}: {} objects, {} live cells, {} too large to classify", number, census.objects, census.population, census.oversized);
+
+		for(const auto& entry : census.entries)
+		{
+			fmt::println(out, "{:>12}  {:<24} {}", entry.count, entry.code, entry.name);
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef LIFE_CENSUS_HPP
+#define LIFE_CENSUS_HPP
+
+#include <Cell.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace life
+{
+    // Objects with more cells than this are counted, but not encoded or classified.
+    constexpr auto censusMaxObjectCells = 256uz;
+
+    // One row of the frequency table.
+    struct CensusEntry
+    {
+        std::string code;       // apgcode-style canonical encoding, e.g. "xs4_33" for a block.
+        std::string_view name;  // Common name of the object, empty if it is not in the catalogue.
+        uint64_t count;
+    };
+
+    struct CensusResult
+    {
+        std::vector<CensusEntry> entries;   // Sorted by descending count.
+        uint64_t objects{};
+        uint64_t oversized{};
+        uint64_t population{};
+    };
+
+    /*
+        Splits the world into objects (8-connected components of live cells) and tallies
+        them by canonical shape. Each band of rows is labelled in parallel; only the
+        components that cross a band boundary are stitched together afterwards, so the
+        serial part of the work is proportional to numBands * width, not to the world size.
+    */
+    [[nodiscard]] CensusResult takeCensus(std::span<const CellState> world, uint64_t width, uint64_t height, std::size_t numBands);
+
+    // Prints the census of the given generation as a table, most common objects first.
+    void printCensus(std::FILE* out, uint64_t number, const CensusResult& census);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include <Checkpoint.hpp>
+#include <array>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define LIFE_HAS_FSYNC 1
+#endif
+
+namespace life
+{
+	namespace
+	{
+		constexpr std::string_view magic = "LIFECKP1";
+
+		volatile std::sig_atomic_t terminationSignalled = 0;
+
+		void onTerminate(int /*signal*/)
+		{
+			terminationSignalled = 1;
+		}
+
+		void putU64(std::ostream& out, uint64_t value)
+		{
+			std::array<char, 8> bytes{};
+			for (auto i = 0u; i < 8u; ++i)
+			{
+				bytes[i] = static_cast<char>(value >> (8u * i));
+			}
+
+			out.write(bytes.data(), bytes.size());
+		}
+
+		uint64_t getU64(std::istream& in)
+		{
+			std::array<char, 8> bytes{};
+			in.read(bytes.data(), bytes.size());
+
+			uint64_t value{};
+			for (auto i = 0u; i < 8u; ++i)
+			{
+				value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8u * i);
+			}
+
+			return value;
+		}
+
+		// Waits until what was written to the file or directory is on disk, not only in the page cache.
+		// fsync() covers the whole file, whichever descriptor it is called on.
+		bool syncToDisk([[maybe_unused]] const std::filesystem::path& path)
+		{
+#if defined(LIFE_HAS_FSYNC)
+			const auto descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (descriptor < 0) { return false; }
+
+			const auto synced = ::fsync(descriptor) == 0;
+			::close(descriptor);
+			return synced;
+#else
+			return true;
+#endif
+		}
+
+		Checkpoint readHeader(std::ifstream& file, const std::string& path, bool& withAges)
+		{
+			std::array<char, magic.size()> tag{};
+
+			if (!file || !file.read(tag.data(), tag.size()) || std::string_view{ tag.data(), tag.size() } != magic)
+			{
+				throw std::runtime_error{ fmt::format("'{}' is not a checkpoint", path) };
+			}
+
+			Checkpoint checkpoint;
+			checkpoint.width = getU64(file);
+			checkpoint.height = getU64(file);
+			checkpoint.generation.number = getU64(file);
+			withAges = getU64(file) != 0u;
+
+			// Guards the allocations that follow against a damaged header.
+			const auto size = checkpoint.width * checkpoint.height;
+			if (!file || checkpoint.width == 0u || checkpoint.height == 0u || size / checkpoint.width != checkpoint.height
+				|| size / 8u > static_cast<uint64_t>(std::filesystem::file_size(path)))
+			{
+				throw std::runtime_error{ fmt::format("Corrupt checkpoint '{}'", path) };
+			}
+
+			return checkpoint;
+		}
+	}
+
+	CheckpointWriter::CheckpointWriter(const std::string& path, uint64_t width, uint64_t height, uint64_t number, bool withAges)
+		: _path(path), _temporary(path + ".tmp"), _file(_temporary, std::ios::binary | std::ios::trunc)
+	{
+		if (!_file)
+		{
+			throw std::runtime_error{ fmt::format("Can't create checkpoint '{}'", _temporary) };
+		}
+
+		_file.write(magic.data(), static_cast<std::streamsize>(magic.size()));
+		putU64(_file, width);
+		putU64(_file, height);
+		putU64(_file, number);
+		putU64(_file, withAges ? 1u : 0u);
+	}
+
+	CheckpointWriter::~CheckpointWriter()
+	{
+		if (_finished) { return; }
+
+		_file.close();
+		std::error_code error;
+		std::filesystem::remove(_temporary, error);
+	}
+
+	void CheckpointWriter::appendCells(std::span<const CellState> cells)
+	{
+		_packed.clear();
+
+		for (const auto cell : cells)
+		{
+			_partial |= static_cast<unsigned>(cell) << (_cellsPacked % 8u);
+
+			if (++_cellsPacked % 8u == 0u)
+			{
+				_packed.push_back(static_cast<char>(_partial));
+				_partial = 0u;
+			}
+		}
+
+		_file.write(_packed.data(), static_cast<std::streamsize>(_packed.size()));
+	}
+
+	void CheckpointWriter::endCells()
+	{
+		if (_cellsEnded) { return; }
+		_cellsEnded = true;
+
+		if (_cellsPacked % 8u != 0u) { _file.put(static_cast<char>(_partial)); }
+	}
+
+	void CheckpointWriter::appendAges(std::span<const uint8_t> ages)
+	{
+		endCells();
+		_file.write(reinterpret_cast<const char*>(ages.data()), static_cast<std::streamsize>(ages.size()));
+	}
+
+	void CheckpointWriter::finish()
+	{
+		endCells();
+		_file.close();
+
+		if (!_file)
+		{
+			throw std::runtime_error{ fmt::format("Can't write checkpoint '{}'", _temporary) };
+		}
+
+		// Otherwise a crash soon after the rename could leave the new name on a file whose contents never reached the disk.
+		if (!syncToDisk(_temporary))
+		{
+			throw std::runtime_error{ fmt::format("Can't write checkpoint '{}' to disk", _temporary) };
+		}
+
+		std::error_code error;
+		std::filesystem::rename(_temporary, _path, error);
+
+		if (error)
+		{
+			throw std::runtime_error{ fmt::format("Can't replace checkpoint '{}': {}", _path, error.message()) };
+		}
+
+		_finished = true;
+
+		// The rename itself only lasts once the directory is on disk.
+		const auto directory = std::filesystem::absolute(_path).parent_path();
+		if (!syncToDisk(directory))
+		{
+			throw std::runtime_error{ fmt::format("Can't write directory '{}' to disk", directory.string()) };
+		}
+	}
+
+	void writeCheckpoint(const std::string& path, uint64_t width, uint64_t height, const Generation& generation)
+	{
+		CheckpointWriter writer{ path, width, height, generation.number, !generation.ages.empty() };
+
+		writer.appendCells(generation.cells);
+		writer.appendAges(generation.ages);
+		writer.finish();
+	}
+
+	Checkpoint readCheckpointHeader(const std::string& path)
+	{
+		std::ifstream file{ path, std::ios::binary };
+		bool withAges = false;
+
+		return readHeader(file, path, withAges);
+	}
+
+	Checkpoint readCheckpoint(const std::string& path)
+	{
+		std::ifstream file{ path, std::ios::binary };
+		bool withAges = false;
+
+		auto checkpoint = readHeader(file, path, withAges);
+		const auto size = checkpoint.width * checkpoint.height;
+
+		std::vector<char> packed((size + 7u) / 8u);
+		file.read(packed.data(), static_cast<std::streamsize>(packed.size()));
+
+		auto& cells = checkpoint.generation.cells;
+		cells.resize(size);
+
+		for (auto i = 0uz; i < cells.size(); ++i)
+		{
+			cells[i] = static_cast<CellState>((static_cast<unsigned>(packed[i / 8u]) >> (i % 8u)) & 1u);
+		}
+
+		if (withAges)
+		{
+			checkpoint.generation.ages.resize(size);
+			file.read(reinterpret_cast<char*>(checkpoint.generation.ages.data()), static_cast<std::streamsize>(size));
+		}
+
+		if (!file)
+		{
+			throw std::runtime_error{ fmt::format("Checkpoint '{}' is cut short", path) };
+		}
+
+		return checkpoint;
+	}
+
+	Checkpointer::Checkpointer(std::string path, uint64_t width, uint64_t height, bool withAges)
+		: _path(std::move(path)), _width(width), _height(height)
+	{
+		// Sized up front, so the buffer the simulation gets back from take() is ready for the next capture.
+		_pending.cells.resize(width * height);
+		if (withAges) { _pending.ages.resize(width * height); }
+
+		_writer = std::jthread{ [this](std::stop_token stop) { writeCheckpoints(stop); } };
+	}
+
+	Checkpointer::~Checkpointer()
+	{
+		_writer.request_stop();
+		_writer.join();
+	}
+
+	bool Checkpointer::take(Generation& generation)
+	{
+		if (_busy) { return false; }
+
+		{
+			std::scoped_lock lock{_lock};
+			std::swap(_pending, generation);
+			_busy = true;
+		}
+
+		_condition.notify_all();
+		return true;
+	}
+
+	void Checkpointer::writeNow(const Generation& generation)
+	{
+		waitIdle();
+
+		try
+		{
+			writeCheckpoint(_path, _width, _height, generation);
+			++_written;
+		}
+		catch (const std::runtime_error&)
+		{
+			_failed = true;
+		}
+	}
+
+	void Checkpointer::waitIdle()
+	{
+		std::unique_lock lock{_lock};
+		_condition.wait(lock, [this]() { return !_busy; });
+	}
+
+	void Checkpointer::writeCheckpoints(std::stop_token stop)
+	{
+		std::unique_lock lock{_lock};
+
+		// Once stopped, a checkpoint already taken is still written.
+		while (_condition.wait(lock, stop, [this]() { return _busy.load(); }) || _busy)
+		{
+			lock.unlock();
+
+			try
+			{
+				writeCheckpoint(_path, _width, _height, _pending);
+				++_written;
+			}
+			catch (const std::runtime_error&)
+			{
+				_failed = true;
+			}
+
+			lock.lock();
+			_busy = false;
+			_condition.notify_all();
+		}
+	}
+
+	void installTerminationHandler()
+	{
+		std::signal(SIGTERM, onTerminate);
+	}
+
+	bool terminationRequested() noexcept
+	{
+		return terminationSignalled != 0;
+	}
+}
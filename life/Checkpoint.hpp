@@ -0,0 +1,137 @@
+#ifndef LIFE_CHECKPOINT_HPP
+#define LIFE_CHECKPOINT_HPP
+
+#include <Generation.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace life
+{
+    /*
+        A checkpoint holds one generation, enough to resume the run from it. The file starts
+        with the magic "LIFECKP1", then the width, height, generation number and whether ages
+        follow, as little-endian 64-bit integers. Then come the cells, one bit per cell, least
+        significant bit first, and finally one byte per cell of ages if they were tracked.
+
+        Checkpoints are written to a temporary file that is renamed over the previous one once
+        complete, so a crash while writing never leaves a broken checkpoint behind.
+    */
+    struct Checkpoint
+    {
+        uint64_t width{};
+        uint64_t height{};
+        Generation generation;
+    };
+
+    /*
+        Writes a checkpoint a piece at a time, so a world that is never all in one place can be
+        saved: first the cells in order, then the ages if there are any. The file at path is
+        only replaced by finish(); a writer destroyed before that leaves it alone.
+    */
+    class CheckpointWriter
+    {
+    public:
+        // Throws std::runtime_error if the temporary file can't be created.
+        CheckpointWriter(const std::string& path, uint64_t width, uint64_t height, uint64_t number, bool withAges);
+        ~CheckpointWriter();
+
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+        CheckpointWriter(CheckpointWriter&&) = delete;
+        CheckpointWriter& operator=(CheckpointWriter&&) = delete;
+
+        void appendCells(std::span<const CellState> cells);
+        void appendAges(std::span<const uint8_t> ages);
+
+        // Makes sure the file is on disk and renames it over the previous checkpoint. Throws std::runtime_error if that fails.
+        void finish();
+
+    private:
+        // Writes out the byte holding the last few cells, once they are all in.
+        void endCells();
+
+        std::string _path;
+        std::string _temporary;
+        std::ofstream _file;
+        std::vector<char> _packed;
+        uint64_t _cellsPacked{};
+        unsigned _partial{};
+        bool _cellsEnded = false;
+        bool _finished = false;
+    };
+
+    // Throws std::runtime_error if the file can't be written.
+    void writeCheckpoint(const std::string& path, uint64_t width, uint64_t height, const Generation& generation);
+
+    // Throws std::runtime_error if the file can't be read or is not a checkpoint.
+    [[nodiscard]] Checkpoint readCheckpoint(const std::string& path);
+
+    // Like readCheckpoint(), but only reads the size and generation number, leaving the cells empty.
+    [[nodiscard]] Checkpoint readCheckpointHeader(const std::string& path);
+
+    /*
+        Writes checkpoints on a background thread. The simulation captures a generation into
+        its own buffer while it keeps running (see Simulation::requestSnapshot()); take() then
+        swaps that buffer with this one, so handing a generation over never copies it.
+    */
+    class Checkpointer
+    {
+    public:
+        Checkpointer(std::string path, uint64_t width, uint64_t height, bool withAges);
+
+        // Finishes the checkpoint being written.
+        ~Checkpointer();
+
+        Checkpointer(const Checkpointer&) = delete;
+        Checkpointer& operator=(const Checkpointer&) = delete;
+        Checkpointer(Checkpointer&&) = delete;
+        Checkpointer& operator=(Checkpointer&&) = delete;
+
+        // True if no checkpoint is being written, i.e. take() would accept the next one.
+        [[nodiscard]] bool idle() const noexcept { return !_busy; }
+
+        // Swaps the generation with this checkpointer's buffer and starts writing it.
+        // Returns false, leaving the generation alone, if the previous checkpoint is still being written.
+        bool take(Generation& generation);
+
+        // Waits for the background write, then writes the generation right away.
+        void writeNow(const Generation& generation);
+
+        [[nodiscard]] uint64_t written() const noexcept { return _written; }
+        [[nodiscard]] bool failed() const noexcept { return _failed; }
+
+    private:
+        void writeCheckpoints(std::stop_token stop);
+        void waitIdle();
+
+        std::string _path;
+        uint64_t _width;
+        uint64_t _height;
+
+        Generation _pending;
+        std::atomic<bool> _busy = false;
+        std::mutex _lock;
+        std::condition_variable_any _condition;
+
+        std::atomic<uint64_t> _written = 0u;
+        std::atomic<bool> _failed = false;
+
+        // Last, so the writer is joined before anything it uses is destroyed.
+        std::jthread _writer;
+    };
+
+    // Makes SIGTERM set a flag instead of ending the process, so a final checkpoint can be written.
+    void installTerminationHandler();
+
+    [[nodiscard]] bool terminationRequested() noexcept;
+}
+
+#endif
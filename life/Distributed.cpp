@@ -0,0 +1,333 @@
+#include <Distributed.hpp>
+#include <Checkpoint.hpp>
+#include <Generation.hpp>
+#include <Kernels.hpp>
+#include <Random.hpp>
+#include <Rendering.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define LIFE_HAS_PROCESSES 1
+#endif
+
+namespace life
+{
+#if defined(LIFE_HAS_PROCESSES)
+	namespace
+	{
+		struct Band
+		{
+			uint64_t firstRow{};
+			uint64_t lastRow{};
+		};
+
+		// The same split the simulation's workers use: the last band takes the rest.
+		Band bandOf(uint64_t rank, uint64_t processes, uint64_t height)
+		{
+			const auto rowsPerProcess = height / processes;
+			const auto firstRow = rowsPerProcess * rank;
+			return Band{ .firstRow=firstRow, .lastRow=(rank + 1u == processes) ? height : firstRow + rowsPerProcess };
+		}
+
+		std::pair<Channel, Channel> connectedPair()
+		{
+			int sockets[2]{};
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+			{
+				throw std::runtime_error{ fmt::format("Can't create a socket pair (errno {})", errno) };
+			}
+
+			return { Channel{ sockets[0] }, Channel{ sockets[1] } };
+		}
+
+		/*
+			Swaps one row with a neighbour. On every link one side sends first while the other
+			receives first, so rows larger than the socket buffers can't deadlock. Ranks
+			alternate between the two, and neighbours always differ by one.
+		*/
+		void swapRows(Channel& neighbour, bool sendFirst, std::span<const uint8_t> outgoing, std::span<uint8_t> incoming)
+		{
+			if (sendFirst)
+			{
+				neighbour.send(outgoing);
+				neighbour.receive(incoming);
+			}
+			else
+			{
+				neighbour.receive(incoming);
+				neighbour.send(outgoing);
+			}
+		}
+
+		// Each process keeps its band with a halo row above and below. At the edges of the world the halo stays dead.
+		void runWorker(uint64_t rank, const Options& options, Band band, Channel* above, Channel* below, Channel& coordinator)
+		{
+			const auto width = options.worldWidth;
+			const auto rows = band.lastRow - band.firstRow;
+			const auto tileWidth = (options.tileWidth > 0u) ? options.tileWidth : autoTileWidth();
+
+			Generation current, next;
+			current.cells.assign((rows + 2u) * width, CellState::Dead);
+			next.cells.assign((rows + 2u) * width, CellState::Dead);
+
+			// Seeded by global cell index, like Simulation::seed().
+			const CounterRng random{ options.seed };
+			for (auto y = band.firstRow; y < band.lastRow; ++y)
+			{
+				for (auto x = 0uz; x < width; ++x)
+				{
+					current.cells[((y - band.firstRow + 1u) * width) + x] = random.chance((y * width) + x, options.density) ? CellState::Alive : CellState::Dead;
+				}
+			}
+
+			const auto row = [&current, width](uint64_t y)
+			{
+				return std::span<uint8_t>{ reinterpret_cast<uint8_t*>(current.cells.data()) + (y * width), width };
+			};
+
+			const bool sendFirst = rank % 2u == 0u;
+
+			for (auto generation = 0uz; generation < options.generations; ++generation)
+			{
+				if (above != nullptr) { swapRows(*above, sendFirst, row(1u), row(0u)); }
+				if (below != nullptr) { swapRows(*below, sendFirst, row(rows), row(rows + 1u)); }
+
+				stepTiled<false>(current, next, width, rows + 2u, 1u, rows + 1u, tileWidth);
+				std::swap(current, next);
+			}
+
+			// The band's population always, its cells only if they are saved.
+			const auto cells = std::span<const CellState>{ current.cells }.subspan(width, rows * width);
+			const auto alive = countAlive(cells);
+			coordinator.send(std::span<const uint8_t>{ reinterpret_cast<const uint8_t*>(&alive), sizeof(alive) });
+
+			if (!options.outputPath.empty())
+			{
+				coordinator.send(std::span<const uint8_t>{ reinterpret_cast<const uint8_t*>(cells.data()), cells.size() });
+			}
+		}
+
+		/*
+			Receives each band in turn and writes it straight into the checkpoint, a chunk at a
+			time, so the whole world is never held in one process. The workers have already sent
+			their populations, so a worker waiting to send its band can't hold up the others.
+		*/
+		void saveBands(const Options& options, std::vector<Channel>& fromWorkers)
+		{
+			constexpr auto chunkSize = 1uz << 20u;
+
+			const auto width = options.worldWidth;
+			const auto processes = fromWorkers.size();
+
+			CheckpointWriter checkpoint{ options.outputPath, width, options.worldHeight, options.generations, false };
+			std::vector<CellState> chunk;
+
+			for (auto rank = 0uz; rank < processes; ++rank)
+			{
+				const auto band = bandOf(rank, processes, options.worldHeight);
+
+				for (auto remaining = (band.lastRow - band.firstRow) * width; remaining > 0u; )
+				{
+					chunk.resize(std::min(remaining, chunkSize));
+					fromWorkers[rank].receive(std::span<uint8_t>{ reinterpret_cast<uint8_t*>(chunk.data()), chunk.size() });
+					checkpoint.appendCells(chunk);
+					remaining -= chunk.size();
+				}
+			}
+
+			checkpoint.finish();
+		}
+	}
+
+	Channel::~Channel()
+	{
+		if (_socket >= 0) { close(_socket); }
+	}
+
+	void Channel::send(std::span<const uint8_t> bytes)
+	{
+		while (!bytes.empty())
+		{
+			const auto sent = ::send(_socket, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+			if (sent < 0 && errno == EINTR) { continue; }
+			if (sent <= 0) { throw std::runtime_error{ fmt::format("Lost a connection while sending (errno {})", errno) }; }
+
+			bytes = bytes.subspan(static_cast<std::size_t>(sent));
+		}
+	}
+
+	void Channel::receive(std::span<uint8_t> bytes)
+	{
+		while (!bytes.empty())
+		{
+			const auto received = ::recv(_socket, bytes.data(), bytes.size(), 0);
+			if (received < 0 && errno == EINTR) { continue; }
+			if (received <= 0) { throw std::runtime_error{ "Lost a connection while receiving" }; }
+
+			bytes = bytes.subspan(static_cast<std::size_t>(received));
+		}
+	}
+
+	int runDistributed(const Options& options)
+	{
+		const auto processes = options.processes;
+		const auto width = options.worldWidth;
+		const auto height = options.worldHeight;
+
+		if (processes == 0u || processes > height)
+		{
+			fmt::println(stderr, "Can't split {} rows over {} processes", height, processes);
+			return EXIT_FAILURE;
+		}
+
+		// The workers always step a seeded world with the tiled kernel, one generation at a time.
+		if (options.kernel != Kernel::Tiled || options.generationsPerPass > 1u || options.heatmap || !options.resumePath.empty() || !options.replayPath.empty())
+		{
+			fmt::println(stderr, "--distributed can't be combined with --kernel reference, --temporal, --heatmap, --resume or --replay");
+			return EXIT_FAILURE;
+		}
+
+		// Links between neighbouring bands, and from each worker to the coordinator.
+		std::vector<std::pair<Channel, Channel>> links, reports;
+		try
+		{
+			for (auto rank = 0uz; rank < processes; ++rank)
+			{
+				if (rank + 1u < processes) { links.push_back(connectedPair()); }
+				reports.push_back(connectedPair());
+			}
+		}
+		catch (const std::runtime_error& err)
+		{
+			fmt::println(stderr, "{}", err.what());
+			return EXIT_FAILURE;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<pid_t> workers;
+
+		for (auto rank = 0uz; rank < processes; ++rank)
+		{
+			const auto pid = fork();
+			if (pid < 0)
+			{
+				fmt::println(stderr, "Can't start worker process {} (errno {})", rank, errno);
+				return EXIT_FAILURE;
+			}
+
+			if (pid == 0)
+			{
+				// Only this worker's ends stay open, so a worker that dies is noticed by its neighbours.
+				std::optional<Channel> above, below;
+				if (rank > 0u) { above.emplace(std::move(links[rank - 1u].second)); }
+				if (rank + 1u < processes) { below.emplace(std::move(links[rank].first)); }
+				Channel coordinator{ std::move(reports[rank].second) };
+
+				links.clear();
+				reports.clear();
+
+				try
+				{
+					runWorker(rank, options, bandOf(rank, processes, height), above ? &*above : nullptr, below ? &*below : nullptr, coordinator);
+				}
+				catch (const std::runtime_error& err)
+				{
+					fmt::println(stderr, "Worker {}: {}", rank, err.what());
+					_exit(EXIT_FAILURE);
+				}
+
+				// The rest of main() belongs to the coordinator.
+				_exit(EXIT_SUCCESS);
+			}
+
+			workers.push_back(pid);
+		}
+
+		// The coordinator only keeps its end of each report.
+		std::vector<Channel> fromWorkers;
+		for (auto& report : reports) { fromWorkers.push_back(std::move(report.first)); }
+		links.clear();
+		reports.clear();
+
+		uint64_t alive = 0u;
+		bool failed = false;
+
+		for (auto rank = 0uz; rank < processes; ++rank)
+		{
+			uint64_t bandAlive = 0u;
+
+			try
+			{
+				fromWorkers[rank].receive(std::span<uint8_t>{ reinterpret_cast<uint8_t*>(&bandAlive), sizeof(bandAlive) });
+				alive += bandAlive;
+			}
+			catch (const std::runtime_error& err)
+			{
+				fmt::println(stderr, "Worker {}: {}", rank, err.what());
+				failed = true;
+			}
+		}
+
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		bool saved = false;
+
+		if (!failed && !options.outputPath.empty())
+		{
+			try
+			{
+				saveBands(options, fromWorkers);
+				saved = true;
+			}
+			catch (const std::runtime_error& err)
+			{
+				fmt::println(stderr, "{}", err.what());
+				failed = true;
+			}
+		}
+
+		// A worker blocked sending its band notices the coordinator giving up.
+		fromWorkers.clear();
+
+		for (const auto pid : workers)
+		{
+			int status = 0;
+			waitpid(pid, &status, 0);
+			failed = failed || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS;
+		}
+
+		if (failed) { return EXIT_FAILURE; }
+
+		fmt::println(stdout, "{} generations of {}x{} on {} processes in {:.3f} s ({:.1f} gen/s), {} cells alive",
+			options.generations, width, height, processes, elapsed.count(),
+			static_cast<double>(options.generations) / elapsed.count(), alive);
+
+		if (saved)
+		{
+			fmt::println(stdout, "Saved generation {} to '{}'", options.generations, options.outputPath);
+		}
+
+		return EXIT_SUCCESS;
+	}
+#else
+	Channel::~Channel() = default;
+	void Channel::send(std::span<const uint8_t> /*bytes*/) { throw std::runtime_error{ "Not supported on this platform" }; }
+	void Channel::receive(std::span<uint8_t> /*bytes*/) { throw std::runtime_error{ "Not supported on this platform" }; }
+
+	int runDistributed(const Options& /*options*/)
+	{
+		fmt::println(stderr, "Distributed mode needs fork() and Unix-domain sockets, which this platform doesn't have");
+		return EXIT_FAILURE;
+	}
+#endif
+}
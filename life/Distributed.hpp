@@ -0,0 +1,48 @@
+#ifndef LIFE_DISTRIBUTED_HPP
+#define LIFE_DISTRIBUTED_HPP
+
+#include <Options.hpp>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+namespace life
+{
+    /*
+        A reliable, ordered stream of bytes to another process, over a connected stream socket.
+        Unix-domain socket pairs connect processes on one machine; a TCP socket would connect
+        processes on different machines the same way. Throws std::runtime_error if the other
+        end goes away.
+    */
+    class Channel
+    {
+    public:
+        explicit Channel(int socket) noexcept : _socket(socket) {}
+        ~Channel();
+
+        Channel(const Channel&) = delete;
+        Channel& operator=(const Channel&) = delete;
+        Channel(Channel&& other) noexcept : _socket(std::exchange(other._socket, -1)) {}
+        Channel& operator=(Channel&& other) = delete;
+
+        void send(std::span<const uint8_t> bytes);
+        void receive(std::span<uint8_t> bytes);
+
+    private:
+        int _socket;
+    };
+
+    /*
+        Runs the simulation without a window, split over options.processes processes that each
+        own a band of rows. After every generation, neighbouring processes swap the rows along
+        their shared edge. Once options.generations have been computed, the coordinator, the
+        process that started the others, adds up the bands' populations and, if asked, streams
+        the bands into a checkpoint that the viewer can --resume. No process holds the whole world.
+
+        The world is seeded exactly like the single-process simulation, so both give the
+        same result. Needs fork() and Unix-domain sockets. Returns the exit code for main().
+    */
+    [[nodiscard]] int runDistributed(const Options& options);
+}
+
+#endif
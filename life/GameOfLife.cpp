@@ -1,172 +1,323 @@
 #include <GameOfLife.hpp>
+#include <Census.hpp>
+#include <Checkpoint.hpp>
+#include <Placement.hpp>
+#include <Random.hpp>
+#include <Rendering.hpp>
 #include <chrono>
 #include <cstdint>
-#include <limits>
-#include <mutex>
-#include <random>
+#include <numeric>
 #include <algorithm>
 #include <execution>
+#include <cmath>
 #include <span>
-#include <barrier>
+#include <stdexcept>
+#include <fmt/format.h>
 
 namespace life
 {	
-	static const auto doDraw = []() noexcept { GameOfLife::drawCurrentState(); };
-
-	static auto& getBarrier() 
+	namespace
 	{
-		static std::barrier drawSync{GameOfLife::_numThreads, doDraw};
-		return drawSync;
+		// A replay has no simulation to share. Reported, and the game ended, by OnUserCreate().
+		std::optional<SharedWorld> openSharedWorld(const Options& options)
+		{
+			if (options.shareName.empty() || !options.replayPath.empty()) { return std::nullopt; }
+
+			try
+			{
+				return std::optional<SharedWorld>{ std::in_place, options.shareName, options.worldWidth, options.worldHeight };
+			}
+			catch (const std::runtime_error& err)
+			{
+				fmt::println(stderr, "{}", err.what());
+				return std::nullopt;
+			}
+		}
 	}
 
-	GameOfLife* GameOfLife::_self;
-	
-	GameOfLife::GameOfLife(uint64_t w, uint64_t h)
-		: currentState(std::vector<CellState>(w * h)),
-		previousState(std::vector<CellState>(w * h)),
-		worldWidth(w), worldHeight(h)
+	GameOfLife::GameOfLife(const Options& options)
+		: _shared(openSharedWorld(options)), worldWidth(options.worldWidth), worldHeight(options.worldHeight), _options(options)
 	{
-		GameOfLife::_self = this;
 		sAppName = "Game of Life Demo";
-		getBarrier();	// Construct the barrier.
+
+		// A replay only reads its log, so it needs neither the workers nor their world buffers.
+		if (options.replayPath.empty())
+		{
+			_simulation.emplace(options.worldWidth, options.worldHeight, _numThreads,
+				SimulationSettings{ .trackAges=options.heatmap, .pinThreads=options.pinThreads,
+					.kernel=options.kernel, .tileWidth=options.tileWidth, .profileLoad=options.profileLoad,
+					.countEvents=options.countEvents, .rebalanceEvery=options.rebalanceEvery,
+					.generationsPerPass=options.logPath.empty() ? options.generationsPerPass : 1u,
+					.frameCells=_shared ? _shared->cells() : std::span<CellState>{} });
+		}
+
+		if (_options.recordPath == "-") { _console = stderr; }
 	}
 
     bool GameOfLife::OnUserCreate()
 	{
-		auto seedTime = std::chrono::steady_clock::now().time_since_epoch().count();
+		if (!_options.replayPath.empty())
+		{
+			try
+			{
+				_replay.emplace(_options.replayPath);
+			}
+			catch (const std::runtime_error& err)
+			{
+				fmt::println(stderr, "{}", err.what());
+				return false;
+			}
+		}
+		else
+		{
+			_heatmap = _simulation->tracksAges();
 
-		// Prime the random generator before building the world.
-		std::minstd_rand random{ static_cast<unsigned int>(seedTime) };
+			try
+			{
+				if (_options.resumePath.empty()) { _simulation->seed(CounterRng{ _options.seed }, _options.density); }
+				else { _simulation->restore(readCheckpoint(_options.resumePath).generation); }
+			}
+			catch (const std::runtime_error& err)
+			{
+				fmt::println(stderr, "{}", err.what());
+				return false;
+			}
 
-		auto numCells = worldWidth * worldWidth;
+			_simulation->setTargetRate(_options.generationsPerSecond);
+		}
 
-		drawQueue.reserve(numCells);
+		// This thread renders; the workers attach themselves once started.
+		if (!_options.tracePath.empty())
+		{
+			_tracer.emplace();
+			_tracer->attach("Render");
+			if (_simulation) { _simulation->setTracer(&*_tracer); }
+		}
 
-		std::ranges::generate(currentState, 
-		[&random](){
-			const auto num = random() % 2;
+		_magnify = std::clamp(_options.cellSize, uint64_t{1}, maxMagnify);
+		cam = { .x=0.f, .y=0.f,
+			.w=static_cast<float>(ScreenWidth()) / static_cast<float>(_magnify),
+			.h=static_cast<float>(ScreenHeight()) / static_cast<float>(_magnify) };
 
-			if(num == 1) { return CellState::Alive; }			
-			return CellState::Dead;
-		});
+		_screenRows.resize(static_cast<std::size_t>(ScreenHeight()));
+		std::iota(_screenRows.begin(), _screenRows.end(), uint64_t{});
+		_shown.cells.resize(static_cast<std::size_t>(ScreenWidth() * ScreenHeight()));
 
-		std::copy(std::execution::par_unseq, currentState.cbegin(), currentState.cend(), previousState.begin());
-		
-		cam = { .x=0.f, .y=0.f, .w=static_cast<float>(ScreenWidth()), .h=static_cast<float>(ScreenHeight()) };
+		// Cells that just died glow red and fade out; live cells go from yellow when born to blue once settled.
+		for (auto age = 0uz; age < 256uz; ++age)
+		{
+			const auto fade = static_cast<float>(std::min(age, 63uz)) / 63.f;
+			const auto mix = [fade](float young, float old) { return static_cast<uint8_t>(young + ((old - young) * fade)); };
 
-		static auto simulatPartialWorld = 
-		[this](std::span<CellState> states, uint64_t offset)
+			_heatPalette[age] = olc::Pixel{ mix(160.f, 0.f), 0, 0 }.n;
+			_heatPalette[256uz + age] = olc::Pixel{ mix(255.f, 64.f), mix(255.f, 128.f), mix(0.f, 255.f) }.n;
+		}
+
+		_worldLayer = static_cast<uint8_t>(CreateLayer());
+		EnableLayer(_worldLayer, true);
+		SetDrawTarget(_worldLayer);
+		Clear(olc::BLACK);
+		SetDrawTarget(nullptr);
+
+		// Zooming out stops once the whole world fits on the screen.
+		while (worldWidth > _maxZoom * static_cast<uint64_t>(ScreenWidth()) || worldHeight > _maxZoom * static_cast<uint64_t>(ScreenHeight()))
 		{
-			std::mutex m;
-			while(_runLoop)
+			_maxZoom *= 2u;
+		}
+
+		if (!_options.recordPath.empty())
+		{
+			// With --temporal, only every pass's last generation is shown. A replay shows every generation.
+			const auto shownPerSecond = _options.generationsPerSecond / static_cast<double>(_simulation ? _simulation->generationsPerPass() : 1u);
+
+			// A paced run is recorded a frame per shown generation. Unlimited runs, and those paced faster than
+			// the display, are recorded a frame per displayed frame, at the rate they are watched at.
+			_recordEveryFrame = !(_options.generationsPerSecond > 0.0 && shownPerSecond < displayRate);
+			const auto framesPerSecond = _recordEveryFrame ? displayRate : shownPerSecond;
+
+			try
+			{
+				_recorder.emplace(_options.recordPath, static_cast<uint64_t>(ScreenWidth()), static_cast<uint64_t>(ScreenHeight()), framesPerSecond);
+			}
+			catch (const std::runtime_error& err)
 			{
-				uint64_t x = 0uz, y = offset / worldWidth;
+				fmt::println(stderr, "{}", err.what());
+				return false;
+			}
+		}
 
-				for(const auto state : states)
-				{
-					uint8_t neighbors = countNeighbors(x, y);
-
-					if (state == CellState::Alive)
-					{
-						if (neighbors == 2 || neighbors == 3)
-						{
-							currentState[(y * worldWidth) + x] = CellState::Alive;
-							std::scoped_lock l{_drawQueueLock};
-							drawQueue.push_back(CellPosition{.x=x, .y=y});
-						}
-						else
-						{ 
-							currentState[(y * worldWidth) + x] = CellState::Dead;
-						}
-					}
-					else
-					{
-						if (neighbors == 3)
-						{
-							currentState[(y * worldWidth) + x] = CellState::Alive;
-							std::scoped_lock l{_drawQueueLock};
-							drawQueue.push_back(CellPosition{.x=x, .y=y});
-						}
-						else
-						{ 
-							currentState[(y * worldWidth) + x] = CellState::Dead;
-						}
-					}
-
-					++x;
-					if(x == worldWidth)
-					{
-						x = 0uz;
-						++y;
-					}
-				}
-
-				getBarrier().arrive_and_wait();
-
-				if(!_simRunning)
+		if (!_options.shareName.empty())
+		{
+			if (_replay)
+			{
+				fmt::println(_console, "Nothing to share while replaying");
+			}
+			else
+			{
+				if (!_shared) { return false; }
+
+				// The seeded world never passes through the completion hook.
+				_shared->publish(_simulation->completed(), _simulation->next());
+				fmt::println(_console, "Sharing the world as '{}'", _shared->name());
+			}
+		}
+
+		if (_options.metricsPort > 0u)
+		{
+			try
+			{
+				_metrics.emplace(_options.metricsPort, [this]()
 				{
-					std::unique_lock lock{m};
-					_simulationWaitCondition.wait(lock, [this](){ return _simRunning; });
-				}
+					const auto counters = this->counters();
+					return MetricsSample{ .generations=counters.generations, .cells=counters.generations * worldWidth * worldHeight,
+						.population=_population, .workers=workers(), .compute=counters.compute, .barrierWait=counters.barrierWait,
+						.render=std::chrono::nanoseconds{ _timeDrawing.load() }, .frames=_framesDrawn, .residentBytes=residentBytes() };
+				});
+			}
+			catch (const std::runtime_error& err)
+			{
+				fmt::println(stderr, "{}", err.what());
+				return false;
+			}
+
+			fmt::println(_console, "Serving metrics on http://127.0.0.1:{}/metrics", _metrics->port());
+		}
+
+		// A replay is already logged.
+		if (!_options.logPath.empty() && !_replay)
+		{
+			try
+			{
+				_log.emplace(_options.logPath, worldWidth, worldHeight, _options.keyframeInterval, _numThreads);
+			}
+			catch (const std::runtime_error& err)
+			{
+				fmt::println(stderr, "{}", err.what());
+				return false;
 			}
-		};
 
-		const auto rowsPerThread = worldHeight / _numThreads;
-		const auto rowsExtra = worldHeight % _numThreads;
-		const auto chunkSize = rowsPerThread * worldWidth;
+			// The seeded world never passes through the completion hook.
+			_simulation->acquireLatest();
+			_log->append(_simulation->latest());
 
-		for(auto i = 0u; i < _numThreads - 1uz; ++i)
+			// Each worker finds the flips in its own band, the completion only joins them.
+			_simulation->setBandHook([this](std::size_t worker, uint64_t firstRow, uint64_t lastRow, const Generation& previous, const Generation& next)
+			{
+				_log->recordBand(worker, firstRow, lastRow, previous.cells, next.cells);
+			});
+		}
+
+		if (!_simulation) { return true; }
+
+		printPlacement();
+		printHugePages();
+
+		if (_options.generationsPerPass > 1u && _simulation->generationsPerPass() == 1u)
 		{
-			_threadPool.emplace_back(simulatPartialWorld, std::span<CellState>{ &previousState[chunkSize * i], chunkSize }, chunkSize * i);
+			fmt::println(_console, "--temporal needs the tiled kernel, without --heatmap or --log; computing one generation per pass");
 		}
 
-		_threadPool.emplace_back(simulatPartialWorld, std::span<CellState>{ &previousState[chunkSize * 3u], chunkSize + rowsExtra }, chunkSize * (_numThreads - 1uz));
+		if (_options.checkpointEvery > 0u)
+		{
+			_checkpointer.emplace(_options.checkpointPath, worldWidth, worldHeight, _simulation->tracksAges());
+			installTerminationHandler();
 
-		return true;
-	}
+			_nextCheckpoint = ((_simulation->completed().number / _options.checkpointEvery) + 1u) * _options.checkpointEvery;
+
+			// If the previous checkpoint is still being written, this one is skipped.
+			_simulation->setSnapshotHook([this](Generation& snapshot) { _checkpointer->take(snapshot); });
+		}
 
-    uint8_t GameOfLife::countNeighbors(uint64_t x, uint64_t y)
-    {
-		auto wrap = [this](uint64_t x, uint64_t y, uint64_t width, uint64_t height)
+		// The census runs on the next completed generation, while the workers are parked at the barrier.
+		// Every generation is logged, not just the ones that get drawn.
+		_simulation->setCompletionHook(
+		[this](const Generation& generation)
 		{
-			if (x == std::numeric_limits<uint64_t>::max() || y == std::numeric_limits<uint64_t>::max()) { return 0u; }
-			if (x >= width || y >= height) { return 0u; }
+			if(_censusRequested.exchange(false))
+			{
+				printCensus(generation);
+			}
 
-			return (previousState[(y * width) + x] == CellState::Alive) ? 1u : 0u;
-		};
+			if(_log)
+			{
+				_log->appendBands(generation.number);
+			}
+
+			// The workers computed it in the segment already, only its slot is named.
+			if(_shared)
+			{
+				_shared->publish(generation, _simulation->next());
+			}
 
-		uint8_t result{};
+			// With temporal blocking, generation numbers may step right over a multiple of the interval.
+			if(_checkpointer && generation.number >= _nextCheckpoint && _checkpointer->idle())
+			{
+				_simulation->requestSnapshot();
+				_nextCheckpoint = ((generation.number / _options.checkpointEvery) + 1u) * _options.checkpointEvery;
+			}
+		});
 
-		result += wrap(x - 1, y - 1, worldWidth, worldHeight);
-		result += wrap(x, y - 1, worldWidth, worldHeight);
-		result += wrap(x + 1, y - 1, worldWidth, worldHeight);
-		result += wrap(x - 1, y, worldWidth, worldHeight);
-		result += wrap(x + 1, y, worldWidth, worldHeight);
-		result += wrap(x - 1, y + 1, worldWidth, worldHeight);
-		result += wrap(x, y + 1, worldWidth, worldHeight);
-		result += wrap(x + 1, y + 1, worldWidth, worldHeight);
+		_simulation->start();
 
-		return result;
+		return true;
 	}
 
     bool GameOfLife::OnUserUpdate(float fElapsedTime)
     {		
+		// SIGTERM: shut down, writing a final checkpoint on the way out.
+		if (terminationRequested()) { return false; }
+
 		if (GetKey(olc::Key::SPACE).bPressed) 
 		{
-			_simRunning = !_simRunning;
-			if(_simRunning)
-			{
-				_simulationWaitCondition.notify_all();
-			}
+			if (_simulation) { _simulation->setPaused(!_simulation->paused()); }
+			else { _replayPaused = !_replayPaused; }
 		}
 
-		if (GetKey(olc::Key::W).bHeld) { cam.y -= 100.f * fElapsedTime; }
-		if (GetKey(olc::Key::S).bHeld) { cam.y += 100.f * fElapsedTime; }
-		if (GetKey(olc::Key::A).bHeld) { cam.x -= 100.f * fElapsedTime; }
-		if (GetKey(olc::Key::D).bHeld) { cam.x += 100.f * fElapsedTime; }
+		if (GetKey(olc::Key::C).bPressed) { _censusRequested = true; }
+		if (GetKey(olc::Key::H).bPressed) { _showHud = !_showHud; }
+		if (GetKey(olc::Key::I).bPressed) { _incrementalRendering = !_incrementalRendering; }
+		// Every pixel changes colour, even while paused.
+		if (GetKey(olc::Key::M).bPressed && _simulation && _simulation->tracksAges())
+		{
+			_heatmap = !_heatmap;
+			_shown.valid = false;
+			_redraw = true;
+		}
 
-		cam.y = std::max(cam.y, 0.f);
-		cam.x = std::max(cam.x, 0.f);
+		const auto previousCam = cam;
+
+		// The mouse wheel magnifies cells up to maxMagnify pixels each, and zooming out further
+		// halves or doubles the cells per screen pixel. The centre of the view stays in place.
+		const auto wheel = GetMouseWheel();
+		if (wheel > 0)
+		{
+			if (_zoom > 1u) { _zoom /= 2u; }
+			else if (_magnify < maxMagnify) { ++_magnify; }
+		}
+		else if (wheel < 0)
+		{
+			if (_magnify > 1u) { --_magnify; }
+			else if (_zoom < _maxZoom) { _zoom *= 2u; }
+		}
+
+		const auto cellsPerPixel = static_cast<float>(_zoom) / static_cast<float>(_magnify);
+		if (cam.w != static_cast<float>(ScreenWidth()) * cellsPerPixel)
+		{
+			const auto centreX = cam.x + (cam.w / 2.f);
+			const auto centreY = cam.y + (cam.h / 2.f);
+
+			cam.w = static_cast<float>(ScreenWidth()) * cellsPerPixel;
+			cam.h = static_cast<float>(ScreenHeight()) * cellsPerPixel;
+			cam.x = centreX - (cam.w / 2.f);
+			cam.y = centreY - (cam.h / 2.f);
+		}
+
+		const auto panSpeed = 100.f * cellsPerPixel * fElapsedTime;
+
+		if (GetKey(olc::Key::W).bHeld) { cam.y -= panSpeed; }
+		if (GetKey(olc::Key::S).bHeld) { cam.y += panSpeed; }
+		if (GetKey(olc::Key::A).bHeld) { cam.x -= panSpeed; }
+		if (GetKey(olc::Key::D).bHeld) { cam.x += panSpeed; }
 
 		const auto dWidth = static_cast<float>(worldWidth);
 		const auto dHeight = static_cast<float>(worldHeight);
@@ -174,35 +325,337 @@ namespace life
 		if (cam.y + cam.h > dHeight) { cam.y = dHeight - cam.h; }
 		if (cam.x + cam.w > dWidth) { cam.x = dWidth - cam.w; }
 
+		cam.y = std::max(cam.y, 0.f);
+		cam.x = std::max(cam.x, 0.f);
+
+		// Render the newest generation at display rate; any generations completed in between are never drawn.
+		// Panning redraws even while the simulation is paused.
+		const auto acquireStarted = std::chrono::steady_clock::now();
+		const bool newGeneration = _simulation ? _simulation->acquireLatest() : advanceReplay(fElapsedTime);
+		trace(TracePhase::Acquire, acquireStarted, std::chrono::steady_clock::now());
+		const bool camMoved = cam.x != previousCam.x || cam.y != previousCam.y || cam.w != previousCam.w;
+		const auto& generation = _simulation ? _simulation->latest() : _replay->current();
+
+		// Without running workers there is no completion hook to take the census.
+		if (!_simulation && _censusRequested.exchange(false))
+		{
+			printCensus(generation);
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now - _rateSampleTime >= std::chrono::milliseconds{ 500 })
+		{
+			const std::chrono::duration<double> elapsed = now - _rateSampleTime;
+			_measuredRate = static_cast<double>(generation.number - _rateSampleGeneration) / elapsed.count();
+			_rateSampleTime = now;
+			_rateSampleGeneration = generation.number;
+
+			const auto counters = this->counters();
+			const auto generations = counters.generations - _timeRunSimulation.generations;
+			const auto compute = static_cast<uint64_t>((counters.compute - _timeRunSimulation.compute).count());
+			_avgTimeRunSimulation = (generations > 0u) ? compute / (generations * workers()) : 0u;
+			_timeRunSimulation = counters;
+
+			const auto frames = _framesDrawn - _sampleFramesDrawn;
+			_avgTimeDrawing = (frames > 0u) ? static_cast<uint64_t>(_timeDrawing - _sampleTimeDrawing) / frames : 0u;
+			_sampleTimeDrawing = _timeDrawing;
+			_sampleFramesDrawn = _framesDrawn;
+
+			// Counting takes a pass over the world, so only while someone is scraping it.
+			if (_metrics) { _population = countAlive(generation.cells); }
+		}
+
+		const auto drawingStarted = std::chrono::steady_clock::now();
+
+		if (newGeneration || camMoved || _redraw)
+		{
+			_redraw = false;
+
+			// The world layer is only uploaded again if one of its pixels actually changed.
+			SetDrawTarget(_worldLayer, false);
+			// Ages change everywhere every generation, so the heatmap is always drawn in full.
+			if (drawGeneration(generation, _incrementalRendering && !_heatmap && !camMoved))
+			{
+				GetLayers()[_worldLayer].bUpdate = true;
+			}
+
+		}
+
+		// The world layer holds the finished frame without the HUD.
+		if (_recorder && (newGeneration || _recordEveryFrame))
+		{
+			_recorder->push(std::span<const uint32_t>{ reinterpret_cast<const uint32_t*>(GetLayers()[_worldLayer].pDrawTarget.Sprite()->GetData()), static_cast<std::size_t>(ScreenWidth() * ScreenHeight()) });
+		}
+
+		// Layer 0 is redrawn every frame anyway, so the HUD costs the world layer nothing.
+		SetDrawTarget(nullptr);
+		Clear(olc::BLANK);
+		if (_showHud) { drawHud(generation); }
+
+		const auto drawingFinished = std::chrono::steady_clock::now();
+		_timeDrawing += std::chrono::duration_cast<std::chrono::nanoseconds>(drawingFinished - drawingStarted).count();
+		trace(TracePhase::Render, drawingStarted, drawingFinished);
+		++_framesDrawn;
+
 		return true;
 	}
 
 	bool GameOfLife::OnUserDestroy()
 	{
-		_runLoop = false;
-		for(auto& thread : _threadPool)
+		if (_metrics)
 		{
-			thread.join();
+			fmt::println(_console, "Served {} metrics scrapes", _metrics->served());
+			_metrics.reset();
+		}
+
+		if (_simulation) { _simulation->stop(); }
+
+		if (_options.profileLoad && _simulation) { printLoadReport(); }
+		if (_options.countEvents && _simulation) { printPerfCounts(); }
+
+		if (_tracer)
+		{
+			Tracer::detach();
+
+			try
+			{
+				_tracer->write(_options.tracePath);
+				fmt::println(_console, "Traced {} spans to '{}'", _tracer->recorded(), _options.tracePath);
+			}
+			catch (const std::runtime_error& err)
+			{
+				fmt::println(stderr, "{}", err.what());
+			}
+		}
+
+		if (_checkpointer)
+		{
+			if (terminationRequested()) { _checkpointer->writeNow(_simulation->completed()); }
+
+			fmt::println(_console, "Wrote {} checkpoints to '{}'{}", _checkpointer->written(), _options.checkpointPath, _checkpointer->failed() ? " (writing failed)" : "");
+			_checkpointer.reset();
+		}
+
+		if (_log)
+		{
+			const auto bytes = _log->bytesWritten();
+			fmt::println(_console, "Logged {} bytes{}", bytes, _log->failed() ? " (writing failed)" : "");
+			_log.reset();
+		}
+
+		if (_shared)
+		{
+			// Removed with the game, once the simulation computing into it is gone.
+			fmt::println(_console, "Shared {} generations as '{}'", _shared->published(), _shared->name());
+		}
+
+		if (_recorder)
+		{
+			_recorder->finish();
+			fmt::println(_console, "Recorded {} frames, dropped {}{}", _recorder->written(), _recorder->dropped(), _recorder->failed() ? " (writing failed)" : "");
+			_recorder.reset();
 		}
 
 		return true;
 	}
 
-	void GameOfLife::drawCurrentState() noexcept
+	SimulationCounters GameOfLife::counters() const noexcept
+	{
+		if (_simulation) { return _simulation->counters(); }
+
+		return SimulationCounters{ .generations=_replayDecoded, .compute=std::chrono::nanoseconds{ _replayDecoding.load() }, .barrierWait={} };
+	}
+
+	bool GameOfLife::advanceReplay(float elapsed)
 	{
-		auto* self = GameOfLife::get();
+		const auto number = _replay->current().number;
+		const auto interval = _replay->header().keyframeInterval;
+		const auto decodingStarted = std::chrono::steady_clock::now();
+		auto decoded = uint64_t{};
+
+		// Stepping and jumping work whether or not the replay is paused.
+		if (GetKey(olc::Key::RIGHT).bPressed) { _replay->seek(number + 1u); }
+		else if (GetKey(olc::Key::LEFT).bPressed) { _replay->seek(number - std::min(number, uint64_t{1})); }
+		else if (GetKey(olc::Key::PGDN).bPressed) { _replay->seek(number + interval); }
+		else if (GetKey(olc::Key::PGUP).bPressed) { _replay->seek(number - std::min(number, interval)); }
+		else if (GetKey(olc::Key::HOME).bPressed) { _replay->seek(_replay->firstGeneration()); }
+		else if (GetKey(olc::Key::END).bPressed) { _replay->seek(_replay->lastGeneration()); }
+		else if (!_replayPaused)
+		{
+			// Played back at the --gps rate, or one generation per frame if unlimited.
+			_replayBacklog = (_options.generationsPerSecond > 0.0) ? _replayBacklog + (elapsed * _options.generationsPerSecond) : 1.0;
+
+			for (; _replayBacklog >= 1.0 && _replay->next(); _replayBacklog -= 1.0) { ++decoded; }
+			_replayBacklog = std::min(_replayBacklog, 1.0);
+		}
+
+		const bool changed = _replay->current().number != _replayShown;
+		_replayShown = _replay->current().number;
+
+		// A jump decodes from a keyframe, but lands on a single generation.
+		if (changed && decoded == 0u) { decoded = 1u; }
+		_replayDecoded += decoded;
+		_replayDecoding += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - decodingStarted).count();
+
+		return changed;
+	}
+
+	bool GameOfLife::drawGeneration(const Generation& generation, bool incremental)
+	{
+		if (_zoom > 1u)
+		{
+			Clear(olc::BLACK);
+			drawDensity(generation);
+			_shown.valid = false;
+			return true;
+		}
+
+		// olc::Pixel is a union over its packed 32-bit value.
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		const std::span<uint32_t> pixels{ reinterpret_cast<uint32_t*>(GetDrawTarget()->GetData()), static_cast<std::size_t>(ScreenWidth() * ScreenHeight()) };
+		const CellColours colours{ .alive=olc::WHITE.n, .dead=olc::BLACK.n, .palette=_heatmap ? std::span<const uint32_t>{ _heatPalette } : std::span<const uint32_t>{} };
+
+		return paintCells(generation, worldWidth, visibleCells(), _magnify, colours, _screenRows, pixels, static_cast<uint64_t>(ScreenWidth()), _shown, incremental);
+	}
 
-		self->Clear(olc::BLACK);
+	void GameOfLife::drawDensity(const Generation& generation)
+	{
+		const auto view = visibleCells();
+		const auto screenWidth = static_cast<uint64_t>(ScreenWidth());
+		const auto zoom = _zoom;
+		const std::span<olc::Pixel> pixels{ GetDrawTarget()->GetData(), static_cast<std::size_t>(ScreenWidth() * ScreenHeight()) };
 
-		std::copy(std::execution::par_unseq, self->currentState.cbegin(), self->currentState.cend(), self->previousState.begin());
+		const auto screenRows = std::min(static_cast<uint64_t>(_screenRows.size()), (view.h + zoom - 1u) / zoom);
+		const auto columns = std::min(screenWidth, (view.w + zoom - 1u) / zoom);
 
-		std::for_each(std::execution::par_unseq, self->drawQueue.cbegin(), self->drawQueue.cend(),
-		[self](const auto& cell)
+		// Every screen row sums its own zoom x zoom blocks, so the rows can be reduced in parallel.
+		std::for_each(std::execution::par, _screenRows.cbegin(), _screenRows.cbegin() + static_cast<std::ptrdiff_t>(screenRows),
+		[&generation, &view, pixels, screenWidth, zoom, columns, this](uint64_t screenY)
 		{
-			self->Draw(olc::vi2d{ static_cast<int>(cell.x), static_cast<int>(cell.y) });
+			const auto firstRow = view.y + (screenY * zoom);
+			const auto lastRow = std::min(firstRow + zoom, view.y + view.h);
+
+			std::vector<uint32_t> counts(columns);
+			for (auto y = firstRow; y < lastRow; ++y)
+			{
+				accumulateDensity(std::span<const CellState>{ generation.cells }.subspan((y * worldWidth) + view.x, view.w), zoom, counts);
+			}
+
+			// Shade by the square root of the density, so sparse regions stay visible.
+			const auto area = static_cast<double>(zoom * zoom);
+			for (auto x = 0uz; x < columns; ++x)
+			{
+				const auto shade = static_cast<uint8_t>(255.0 * std::sqrt(static_cast<double>(counts[x]) / area));
+				pixels[(screenY * screenWidth) + x] = olc::Pixel{ shade, shade, shade };
+			}
 		});
+	}
+
+	void GameOfLife::drawHud(const Generation& generation)
+	{
+		const auto target = (_options.generationsPerSecond > 0.0) ? fmt::format("{:g}", _options.generationsPerSecond) : std::string{ "unlimited" };
+
+		DrawString(olc::vi2d{ 2, 2 }, fmt::format("Generation {}", generation.number), olc::YELLOW);
+		DrawString(olc::vi2d{ 2, 12 }, fmt::format("{:.1f} gen/s (target: {})", _measuredRate, target), olc::YELLOW);
+
+		DrawString(olc::vi2d{ 2, 22 }, fmt::format("Step {:.1f} us/gen, draw {:.1f} us/frame",
+			static_cast<double>(_avgTimeRunSimulation) / 1000.0, static_cast<double>(_avgTimeDrawing) / 1000.0), olc::YELLOW);
+
+		if (_options.profileLoad && _simulation)
+		{
+			DrawString(olc::vi2d{ 2, 32 }, fmt::format("Imbalance {:.2f} (slowest worker over the mean)", _simulation->imbalance()), olc::YELLOW);
+		}
+
+		if (_replay)
+		{
+			DrawString(olc::vi2d{ 2, 32 }, fmt::format("Replay of generations {} to {}", _replay->firstGeneration(), _replay->lastGeneration()), olc::YELLOW);
+		}
+	}
+
+	void GameOfLife::printLoadReport() const
+	{
+		const auto report = _simulation->loadReport();
+		const auto seconds = [](std::chrono::nanoseconds time) { return std::chrono::duration<double>{ time }.count(); };
+
+		fmt::println(_console, "Load over {} generations: imbalance {:.2f} on average, {:.2f} at worst, {:.2f} over the whole run",
+			report.generations, report.meanImbalance, report.worstImbalance, report.runImbalance);
 
-		self->drawQueue.clear();
+		for (auto i = 0uz; i < report.workers.size(); ++i)
+		{
+			const auto& worker = report.workers[i];
+			const auto busy = seconds(worker.compute + worker.barrierWait);
 
+			fmt::println(_console, "Worker {}: rows {} to {}, computing {:.3f} s, waiting {:.3f} s ({:.0f}%), {:.0f} cells alive on average", i,
+				worker.firstRow, worker.lastRow, seconds(worker.compute), seconds(worker.barrierWait),
+				(busy > 0.0) ? 100.0 * seconds(worker.barrierWait) / busy : 0.0, worker.population);
+		}
+	}
+
+	void GameOfLife::printPerfCounts() const
+	{
+		const auto& workers = _simulation->perfCounts();
+		if (workers.empty() || workers[0][PerfEvent::Cycles] < 0)
+		{
+			fmt::println(_console, "Hardware counters are unavailable; perf_event_open needs /proc/sys/kernel/perf_event_paranoid at 2 or below, and a PMU");
+			return;
+		}
+
+		const auto print = [this](std::string_view who, const PerfCounts& counts)
+		{
+			const auto cells = static_cast<double>(std::max(counts.cells, uint64_t{1}));
+			const auto perCell = [&counts, cells](PerfEvent event)
+			{
+				return (counts[event] >= 0) ? fmt::format("{:.3f}", static_cast<double>(counts[event]) / cells) : std::string{ "n/a" };
+			};
+			const auto ipc = (counts[PerfEvent::Instructions] >= 0 && counts[PerfEvent::Cycles] > 0)
+				? fmt::format("{:.2f}", static_cast<double>(counts[PerfEvent::Instructions]) / static_cast<double>(counts[PerfEvent::Cycles])) : std::string{ "n/a" };
+
+			fmt::println(_console, "{}: IPC {}, per cell {} cycles, {} L1 misses, {} LLC misses, {} branch misses", who,
+				ipc, perCell(PerfEvent::Cycles), perCell(PerfEvent::L1Misses), perCell(PerfEvent::LastLevelMisses), perCell(PerfEvent::BranchMisses));
+		};
+
+		PerfCounts total{ .values={ 0, 0, 0, 0, 0 }, .cells=0u };
+		for (auto i = 0uz; i < workers.size(); ++i)
+		{
+			print(fmt::format("Worker {}", i), workers[i]);
+			total += workers[i];
+		}
+
+		print(fmt::format("{} kernel", (_simulation->kernel() == Kernel::Tiled) ? "Tiled" : "Reference"), total);
+	}
+
+	void GameOfLife::printPlacement() const
+	{
+		// Only worth mentioning where there is a choice to be made.
+		if (!_options.pinThreads && numaNodeCount() <= 1) { return; }
+
+		const auto known = [](int value) { return (value >= 0) ? fmt::format("{}", value) : std::string{ "?" }; };
+
+		for (auto i = 0uz; i < _simulation->placement().size(); ++i)
+		{
+			const auto& placement = _simulation->placement()[i];
+
+			fmt::println(_console, "Worker {}: rows {} to {}, {} CPU {} on node {}, memory on node {}", i,
+				placement.firstRow, placement.lastRow, placement.pinned ? "pinned to" : "started on",
+				known(placement.cpu), known(placement.cpuNode), known(placement.memoryNode));
+		}
+	}
+
+	void GameOfLife::printHugePages() const
+	{
+		const auto report = hugePageReport();
+		const auto mebibytes = [](uint64_t bytes) { return bytes >> 20u; };
+
+		// Small worlds never get near a huge page.
+		if (report.explicitBytes + report.transparentBytes + report.ordinaryBytes == 0u) { return; }
+
+		fmt::println(_console, "World buffers: {} MiB on reserved huge pages, {} MiB asking for transparent huge pages, {} MiB on ordinary pages; "
+			"{} MiB of the process is backed by transparent huge pages", mebibytes(report.explicitBytes), mebibytes(report.transparentBytes),
+			mebibytes(report.ordinaryBytes), mebibytes(report.transparentBacked));
+	}
+
+	void GameOfLife::printCensus(const Generation& generation) const
+	{
+		life::printCensus(_console, generation.number, takeCensus(generation.cells, worldWidth, worldHeight, std::thread::hardware_concurrency()));
 	}
 }
\ No newline at end of file
@@ -4,66 +4,152 @@
 #include <chrono>
 #include <olcPixelGameEngine.h>
 #include <Camera.hpp>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
+#include <Cell.hpp>
+#include <Checkpoint.hpp>
+#include <GenerationLog.hpp>
+#include <Metrics.hpp>
+#include <Options.hpp>
+#include <Recorder.hpp>
+#include <Rendering.hpp>
+#include <SharedWorld.hpp>
+#include <Simulation.hpp>
+#include <Trace.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <optional>
 
 namespace life
 {
-    enum class CellState : uint8_t { Dead = 0u, Alive };
-
-    // Used in the drawQueue to determine which cells to draw at the end of an epoch.
-    struct CellPosition
-    {
-        uint64_t x, y;
-    };
-
     class GameOfLife : public olc::PixelGameEngine
     {
     public:
         
-        GameOfLife(uint64_t w, uint64_t h);
+        explicit GameOfLife(const Options& options);
         
         bool OnUserCreate() override;
         bool OnUserUpdate(float fElapsedTime) override;
         bool OnUserDestroy() override;
-        void transformStates();
 
-        static void drawCurrentState() noexcept;
+        // Moves the replay along, or to wherever the keys ask for. Returns true if the generation changed.
+        bool advanceReplay(float elapsed);
 
-        [[nodiscard]] static constexpr GameOfLife* get() { return _self; }
+        // The simulation's running totals or, while replaying, the generations decoded from the log and the
+        // time spent decoding them on the render thread. Read by the HUD and the metrics server.
+        [[nodiscard]] SimulationCounters counters() const noexcept;
+        [[nodiscard]] std::size_t workers() const noexcept { return _simulation ? _numThreads : 1uz; }
 
-        [[nodiscard]] uint8_t countNeighbors(uint64_t x, uint64_t y);
-        
-        [[nodiscard]] constexpr bool withinView(float x, float y) const
+        bool drawGeneration(const Generation& generation, bool incremental);
+        void drawDensity(const Generation& generation);
+        void drawHud(const Generation& generation);
+        void printCensus(const Generation& generation) const;
+
+        // Which CPU and NUMA node each worker and its band of the world ended up on.
+        void printPlacement() const;
+
+        // Whether the world buffers got the huge pages asked for.
+        void printHugePages() const;
+
+        // How evenly the workers shared the run, with --profile-load.
+        void printLoadReport() const;
+
+        // What the step kernel cost in hardware events, with --perf-counters.
+        void printPerfCounts() const;
+
+        // Rendering only ever touches these cells, so its cost is bounded by the screen, not the world.
+        [[nodiscard]] CellRect visibleCells() const
         {
-            return (x >= cam.x && x < cam.x + cam.w && y >= cam.y && y < cam.y + cam.h);
+            const auto x = std::min(static_cast<uint64_t>(std::max(cam.x, 0.f)), worldWidth);
+            const auto y = std::min(static_cast<uint64_t>(std::max(cam.y, 0.f)), worldHeight);
+
+            // Magnified cells at the right and bottom edges may only be partly on screen.
+            return CellRect{ .x=x, .y=y,
+                .w=std::min(static_cast<uint64_t>(std::ceil(cam.w)), worldWidth - x),
+                .h=std::min(static_cast<uint64_t>(std::ceil(cam.h)), worldHeight - y) };
         }
 
         static constexpr auto _numThreads = 4uz;
 
     private:
-        // Two copies of the map are needed to avoid contaminating the simulation.
-        std::vector<CellState> currentState, previousState;
-        std::vector<CellPosition> drawQueue;
+        // Outlives the simulation's workers, which record into it.
+        std::optional<Tracer> _tracer;
+
+        // Holds the simulation's generations, for viewers in other processes, so it goes first.
+        std::optional<SharedWorld> _shared;
+
+        // Runs on its own threads; the window only ever looks at the newest published generation.
+        // Not created while replaying.
+        std::optional<Simulation> _simulation;
+        std::vector<uint64_t> _screenRows;
 
         uint64_t worldWidth;
         uint64_t worldHeight;
         Camera cam{};
 
-        std::chrono::duration<uint64_t, std::micro> _timeRunSimulation = std::chrono::duration<uint64_t>::zero();
-        uint64_t _avgTimeRunSimulation{};
+        // Cells per screen pixel along each axis. Above 1, pixels show the density of their block.
+        uint64_t _zoom = 1u, _maxZoom = 1u;
 
-        std::chrono::duration<uint64_t, std::micro> _timeDrawing = std::chrono::duration<uint64_t>::zero();
-        uint64_t _avgTimeDrawing{};
+        // Screen pixels per cell along each axis, when zoomed in.
+        uint64_t _magnify = 1u;
+        Options _options;
 
-        std::vector<std::jthread> _threadPool;
-        std::condition_variable _simulationWaitCondition;
-        std::mutex _drawQueueLock;
+        // The workers' compute time per generation, averaged over the workers, and the time per
+        // drawn frame, both averaged over the last rate sample for the HUD. In nanoseconds.
+        SimulationCounters _timeRunSimulation{};
+        uint64_t _avgTimeRunSimulation{};
 
-        static GameOfLife* _self;
+        // Running totals, also read by the metrics server while the game runs.
+        std::atomic<int64_t> _timeDrawing = 0;
+        std::atomic<uint64_t> _framesDrawn = 0u;
+        std::atomic<uint64_t> _population = 0u;
+        int64_t _sampleTimeDrawing{};
+        uint64_t _sampleFramesDrawn{};
+        uint64_t _avgTimeDrawing{};
 
-        bool _simRunning = true, _runLoop = true;
+        // Generation rate, measured over the last half second for the HUD.
+        std::chrono::steady_clock::time_point _rateSampleTime{};
+        uint64_t _rateSampleGeneration{};
+        double _measuredRate{};
+        bool _showHud = true;
+
+        // The world is drawn on its own layer, beneath the HUD on layer 0. While the camera stays put,
+        // only the pixels whose cell flipped since the last frame are written; _shown holds what is on screen.
+        // _redraw draws the next frame in full, even without a new generation.
+        uint8_t _worldLayer{};
+        ShownCells _shown;
+        bool _incrementalRendering = true, _redraw = false;
+
+        // Colours for the heatmap, indexed by state and age as expandRowPalette() expects.
+        std::array<uint32_t, 512> _heatPalette{};
+        bool _heatmap = false;
+
+        std::atomic<bool> _censusRequested = false;
+
+        // Every newly drawn generation, or every displayed frame, is queued for recording. Messages go to stderr
+        // while the video goes to stdout. The window is shown with vsync, taken to be at displayRate.
+        static constexpr double displayRate = 60.0;
+        std::optional<Recorder> _recorder;
+        bool _recordEveryFrame = false;
+        std::FILE* _console = stdout;
+
+        // Logging the run, or replaying a logged one instead of simulating.
+        std::optional<LogWriter> _log;
+        std::optional<LogReader> _replay;
+        uint64_t _replayShown = std::numeric_limits<uint64_t>::max();
+        double _replayBacklog{};
+        bool _replayPaused = false;
+        std::atomic<uint64_t> _replayDecoded = 0u;
+        std::atomic<int64_t> _replayDecoding = 0;
+
+        // Writes checkpoints in the background while the simulation keeps running.
+        std::optional<Checkpointer> _checkpointer;
+        uint64_t _nextCheckpoint{};
+
+        // Reads the totals above from its own thread, so it goes first.
+        std::optional<MetricsServer> _metrics;
     };
     
 }
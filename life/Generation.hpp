@@ -0,0 +1,21 @@
+#ifndef LIFE_GENERATION_HPP
+#define LIFE_GENERATION_HPP
+
+#include <WorldBuffer.hpp>
+#include <cstdint>
+
+namespace life
+{
+    // One complete state of the world.
+    struct Generation
+    {
+        CellBuffer cells;
+
+        // Generations since each cell last changed state, saturating at 255. Empty unless ages are tracked.
+        AgeBuffer ages;
+
+        uint64_t number{};
+    };
+}
+
+#endif
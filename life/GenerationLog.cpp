@@ -0,0 +1,420 @@
+#include <GenerationLog.hpp>
+#include <Rendering.hpp>
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <fmt/format.h>
+
+namespace life
+{
+	namespace
+	{
+		constexpr std::string_view magic = "LIFELOG1";
+		constexpr auto headerSize = 32uz;
+		constexpr char keyframeTag = 'K', deltaTag = 'D';
+
+		void putU64(std::vector<uint8_t>& out, uint64_t value)
+		{
+			for (auto i = 0u; i < 8u; ++i)
+			{
+				out.push_back(static_cast<uint8_t>(value >> (8u * i)));
+			}
+		}
+
+		void putVarint(std::vector<uint8_t>& out, uint64_t value)
+		{
+			while (value >= 0x80u)
+			{
+				out.push_back(static_cast<uint8_t>(value | 0x80u));
+				value >>= 7u;
+			}
+
+			out.push_back(static_cast<uint8_t>(value));
+		}
+
+		bool readU64(std::istream& in, uint64_t& value)
+		{
+			std::array<char, 8> bytes{};
+			if (!in.read(bytes.data(), bytes.size())) { return false; }
+
+			value = 0u;
+			for (auto i = 0u; i < 8u; ++i)
+			{
+				value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8u * i);
+			}
+
+			return true;
+		}
+
+		// Returns false if the varint runs past the end of the payload.
+		bool getVarint(std::span<const uint8_t> in, std::size_t& position, uint64_t& value)
+		{
+			value = 0u;
+			for (auto shift = 0u; position < in.size() && shift < 64u; shift += 7u)
+			{
+				const auto byte = in[position++];
+				value |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+
+				if ((byte & 0x80u) == 0u) { return true; }
+			}
+
+			return false;
+		}
+
+		std::runtime_error corrupt(std::string_view reason)
+		{
+			return std::runtime_error{ fmt::format("Corrupt generation log: {}", reason) };
+		}
+	}
+
+	LogWriter::LogWriter(const std::string& path, uint64_t width, uint64_t height, uint64_t keyframeInterval, std::size_t bands)
+		: _width(width), _height(height), _keyframeInterval(std::max(keyframeInterval, uint64_t{1})),
+		_file(path, std::ios::binary | std::ios::trunc), _bands(std::max(bands, 1uz))
+	{
+		if (!_file)
+		{
+			throw std::runtime_error{ fmt::format("Can't create generation log '{}'", path) };
+		}
+
+		_encoded.assign(magic.begin(), magic.end());
+		putU64(_encoded, _width);
+		putU64(_encoded, _height);
+		putU64(_encoded, _keyframeInterval);
+		_file.write(reinterpret_cast<const char*>(_encoded.data()), static_cast<std::streamsize>(_encoded.size()));
+		_bytesWritten = _encoded.size();
+
+		_writer = std::jthread{ [this](std::stop_token stop) { writeRecords(stop); } };
+	}
+
+	LogWriter::~LogWriter()
+	{
+		_writer.request_stop();
+		_writer.join();
+	}
+
+	void LogWriter::append(const Generation& generation)
+	{
+		const auto& cells = generation.cells;
+		auto entry = reserve((cells.size() + 7u) / 8u);
+
+		entry.number = generation.number;
+		entry.keyframe = true;
+		entry.payload.assign((cells.size() + 7u) / 8u, uint8_t{});
+
+		for (auto i = 0uz; i < cells.size(); ++i)
+		{
+			entry.payload[i / 8u] |= static_cast<uint8_t>(static_cast<unsigned>(cells[i]) << (i % 8u));
+		}
+
+		enqueue(std::move(entry));
+	}
+
+	void LogWriter::recordBand(std::size_t band, uint64_t firstRow, uint64_t lastRow, std::span<const CellState> previous, std::span<const CellState> next)
+	{
+		auto& delta = _bands[band];
+		const auto begin = firstRow * _width;
+		const auto count = (lastRow - firstRow) * _width;
+
+		delta.gaps.clear();
+		delta.end = begin;
+		auto first = true;
+
+		delta.flips = forEachFlip(previous.subspan(begin, count), next.subspan(begin, count), [&delta, &first, begin](std::size_t x)
+		{
+			const auto index = begin + x;
+
+			if (first) { delta.first = index; }
+			else { putVarint(delta.gaps, index - delta.end); }
+
+			first = false;
+
+			delta.end = index + 1u;
+		});
+	}
+
+	void LogWriter::appendBands(uint64_t number)
+	{
+		auto bytes = 0uz;
+		for (const auto& delta : _bands) { bytes += delta.gaps.size() + 10u; }
+
+		auto entry = reserve(bytes);
+		entry.number = number;
+		entry.flips = 0u;
+		entry.keyframe = false;
+		entry.payload.clear();
+
+		// Each band's gaps carry on from its first flip, which is re-encoded from the end of the band before.
+		auto end = 0uz;
+		for (const auto& delta : _bands)
+		{
+			if (delta.flips == 0u) { continue; }
+
+			putVarint(entry.payload, delta.first - end);
+			entry.payload.insert(entry.payload.end(), delta.gaps.begin(), delta.gaps.end());
+			entry.flips += delta.flips;
+			end = delta.end;
+		}
+
+		enqueue(std::move(entry));
+	}
+
+	LogWriter::Entry LogWriter::reserve(std::size_t bytes)
+	{
+		std::unique_lock lock{_queueLock};
+
+		// A generation larger than the whole queue still goes through on its own.
+		_spaceCondition.wait(lock, [this, bytes]() { return _queue.empty() || _queuedBytes + bytes <= queueBytes; });
+		if (_spare.empty()) { return Entry{}; }
+
+		auto entry = std::move(_spare.front());
+		_spare.pop_front();
+		return entry;
+	}
+
+	void LogWriter::enqueue(Entry entry)
+	{
+		{
+			std::scoped_lock lock{_queueLock};
+			_queuedBytes += entry.payload.size();
+			_queue.push_back(std::move(entry));
+		}
+
+		_queueCondition.notify_one();
+	}
+
+	void LogWriter::writeRecords(std::stop_token stop)
+	{
+		std::unique_lock lock{_queueLock};
+
+		// Once stopped, the generations already queued are still written.
+		while (_queueCondition.wait(lock, stop, [this]() { return !_queue.empty(); }) || !_queue.empty())
+		{
+			auto entry = std::move(_queue.front());
+			_queue.pop_front();
+			const auto queued = entry.payload.size();
+			lock.unlock();
+
+			if (!_failed) { writeRecord(entry); }
+
+			lock.lock();
+			_queuedBytes -= queued;
+			_spare.push_back(std::move(entry));
+			_spaceCondition.notify_one();
+		}
+
+		_file.flush();
+	}
+
+	void LogWriter::writeRecord(Entry& entry)
+	{
+		const auto number = entry.number;
+
+		if (entry.keyframe)
+		{
+			// The entry takes the old world back as its spare buffer.
+			std::swap(_world, entry.payload);
+		}
+		else
+		{
+			if (!_hasPrevious) { return; }
+
+			auto position = 0uz;
+			auto index = 0uz;
+
+			for (auto i = 0uz; i < entry.flips; ++i)
+			{
+				uint64_t gap{};
+				getVarint(entry.payload, position, gap);
+				index += gap;
+				_world[index / 8u] ^= static_cast<uint8_t>(1u << (index % 8u));
+				++index;
+			}
+		}
+
+		_encoded.clear();
+
+		// A keyframe whenever the numbering reaches a multiple of the interval.
+		if (entry.keyframe || number / _keyframeInterval != _previousNumber / _keyframeInterval)
+		{
+			_encoded.push_back(static_cast<uint8_t>(keyframeTag));
+			putU64(_encoded, number);
+			write(_encoded);
+			write(_world);
+		}
+		else
+		{
+			_encoded.push_back(static_cast<uint8_t>(deltaTag));
+			putU64(_encoded, number);
+			putU64(_encoded, entry.flips);
+			putU64(_encoded, entry.payload.size());
+			write(_encoded);
+			write(entry.payload);
+		}
+
+		_previousNumber = number;
+		_hasPrevious = true;
+	}
+
+	void LogWriter::write(std::span<const uint8_t> bytes)
+	{
+		if (_file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+		{
+			_bytesWritten += bytes.size();
+		}
+		else
+		{
+			_failed = true;
+		}
+	}
+
+	LogReader::Header LogReader::readHeader(const std::string& path)
+	{
+		std::ifstream file{ path, std::ios::binary };
+		if (!file)
+		{
+			throw std::runtime_error{ fmt::format("Can't open generation log '{}'", path) };
+		}
+
+		std::array<char, magic.size()> tag{};
+		Header header;
+
+		if (!file.read(tag.data(), tag.size()) || std::string_view{ tag.data(), tag.size() } != magic
+			|| !readU64(file, header.width) || !readU64(file, header.height) || !readU64(file, header.keyframeInterval)
+			|| header.width == 0u || header.height == 0u)
+		{
+			throw std::runtime_error{ fmt::format("'{}' is not a generation log", path) };
+		}
+
+		return header;
+	}
+
+	LogReader::LogReader(const std::string& path)
+		: _header(readHeader(path)), _file(path, std::ios::binary)
+	{
+		_current.cells.resize(_header.width * _header.height);
+
+		_file.seekg(0, std::ios::end);
+		_fileSize = _file.tellg();
+
+		// Index the keyframes, stopping at the first incomplete record.
+		_file.seekg(static_cast<std::streamoff>(headerSize));
+		for (auto offset = _file.tellg(); ; offset = _file.tellg())
+		{
+			const auto record = readRecord(false);
+			if (record == Record::End) { break; }
+
+			if (record == Record::Keyframe) { _keyframes.emplace_back(_recordNumber, offset); }
+			else if (_keyframes.empty()) { throw corrupt("it doesn't start with a keyframe"); }
+
+			_lastGeneration = _recordNumber;
+		}
+
+		if (_keyframes.empty()) { throw corrupt("it holds no generations"); }
+
+		_file.clear();
+		seek(firstGeneration());
+	}
+
+	void LogReader::seek(uint64_t generation)
+	{
+		generation = std::clamp(generation, firstGeneration(), _lastGeneration);
+
+		const auto keyframe = std::prev(std::ranges::upper_bound(_keyframes, generation, {}, &std::pair<uint64_t, std::streamoff>::first));
+
+		// Going forwards from the current generation is cheaper than from the keyframe, if it was passed already.
+		if (!_loaded || generation < _current.number || _current.number < keyframe->first)
+		{
+			_file.clear();
+			_file.seekg(keyframe->second);
+			readRecord(true);
+			_loaded = true;
+		}
+
+		while (_current.number < generation && next()) {}
+	}
+
+	bool LogReader::next()
+	{
+		if (_current.number >= _lastGeneration) { return false; }
+
+		return readRecord(true) != Record::End;
+	}
+
+	LogReader::Record LogReader::readRecord(bool apply)
+	{
+		char tag{};
+		uint64_t number{};
+
+		if (!_file.get(tag) || !readU64(_file, number)) { return Record::End; }
+
+		const auto remaining = [this](uint64_t bytes)
+		{
+			return static_cast<uint64_t>(_fileSize - static_cast<std::streamoff>(_file.tellg())) >= bytes;
+		};
+
+		const auto load = [this](uint64_t bytes)
+		{
+			_payload.resize(bytes);
+			return static_cast<bool>(_file.read(reinterpret_cast<char*>(_payload.data()), static_cast<std::streamsize>(bytes)));
+		};
+
+		auto& cells = _current.cells;
+		_recordNumber = number;
+
+		if (tag == keyframeTag)
+		{
+			const auto bytes = (cells.size() + 7u) / 8u;
+			if (!remaining(bytes)) { return Record::End; }
+
+			if (!apply)
+			{
+				_file.seekg(static_cast<std::streamoff>(bytes), std::ios::cur);
+				return Record::Keyframe;
+			}
+
+			if (!load(bytes)) { return Record::End; }
+
+			for (auto i = 0uz; i < cells.size(); ++i)
+			{
+				cells[i] = static_cast<CellState>((_payload[i / 8u] >> (i % 8u)) & 1u);
+			}
+
+			_current.number = number;
+			return Record::Keyframe;
+		}
+
+		if (tag != deltaTag) { throw corrupt(fmt::format("unknown record type {}", static_cast<int>(tag))); }
+
+		uint64_t flips{}, bytes{};
+		if (!readU64(_file, flips) || !readU64(_file, bytes) || !remaining(bytes)) { return Record::End; }
+
+		if (!apply)
+		{
+			_file.seekg(static_cast<std::streamoff>(bytes), std::ios::cur);
+			return Record::Delta;
+		}
+
+		if (!load(bytes)) { return Record::End; }
+
+		auto position = 0uz;
+		auto index = 0uz;
+
+		for (auto i = 0uz; i < flips; ++i)
+		{
+			uint64_t gap{};
+			if (!getVarint(_payload, position, gap) || index + gap >= cells.size())
+			{
+				throw corrupt(fmt::format("bad delta for generation {}", number));
+			}
+
+			index += gap;
+			cells[index] = (cells[index] == CellState::Alive) ? CellState::Dead : CellState::Alive;
+			++index;
+		}
+
+		_current.number = number;
+		return Record::Delta;
+	}
+}
@@ -0,0 +1,181 @@
+#ifndef LIFE_GENERATIONLOG_HPP
+#define LIFE_GENERATIONLOG_HPP
+
+#include <Cell.hpp>
+#include <Generation.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace life
+{
+    /*
+        A log of every generation of a run, replayable without simulating it again.
+
+        The file starts with a header: the magic "LIFELOG1", then the width, height and
+        keyframe interval as little-endian 64-bit integers. Records follow, each starting
+        with a type byte and the generation number:
+
+        'K' keyframe: the whole world, one bit per cell, least significant bit first.
+        'D' delta:    the number of flipped cells, the payload size in bytes, then the
+                      index of every flipped cell as a LEB128 varint gap from the previous
+                      flip plus one. Only the cells that changed are stored, so a settled
+                      world costs a few bytes per generation.
+
+        Keyframes are written whenever the generation number is a multiple of the interval,
+        which bounds how many deltas a seek has to apply.
+    */
+    class LogWriter
+    {
+    public:
+        // Bytes of generations waiting to be written, beyond which appending waits for the writer.
+        static constexpr auto queueBytes = 64uz << 20u;
+
+        // With one band per worker, see recordBand(). Throws std::runtime_error if the file can't be created.
+        LogWriter(const std::string& path, uint64_t width, uint64_t height, uint64_t keyframeInterval, std::size_t bands = 1uz);
+
+        // Writes every generation still in the queue before closing the file.
+        ~LogWriter();
+
+        LogWriter(const LogWriter&) = delete;
+        LogWriter& operator=(const LogWriter&) = delete;
+        LogWriter(LogWriter&&) = delete;
+        LogWriter& operator=(LogWriter&&) = delete;
+
+        // Queues a whole generation as a keyframe, packing it in a pass over the world. Deltas
+        // are only logged after one.
+        void append(const Generation& generation);
+
+        // Worker side, before the barrier: encodes the cells of rows firstRow to lastRow that
+        // changed from previous to next into the band's slot. Each band has its own worker.
+        void recordBand(std::size_t band, uint64_t firstRow, uint64_t lastRow, std::span<const CellState> previous, std::span<const CellState> next);
+
+        /*
+            Once every band is recorded, e.g. in the completion: joins the bands into the delta
+            that leads to generation number and queues it. Costs the size of the delta, not of
+            the world. Unlike dropping a video frame, dropping a generation would break the log,
+            so this blocks while the queue is full.
+        */
+        void appendBands(uint64_t number);
+
+        [[nodiscard]] uint64_t bytesWritten() const noexcept { return _bytesWritten; }
+        [[nodiscard]] bool failed() const noexcept { return _failed; }
+
+    private:
+        // A keyframe's packed cells, or a delta's payload.
+        struct Entry
+        {
+            uint64_t number{};
+            uint64_t flips{};
+            bool keyframe = false;
+            std::vector<uint8_t> payload;
+        };
+
+        // One worker's flips: the first one's index, the gaps to the others, and one past the last.
+        struct alignas(64) BandDelta
+        {
+            uint64_t flips{};
+            uint64_t first{};
+            uint64_t end{};
+            std::vector<uint8_t> gaps;
+        };
+
+        // Waits until bytes more fit in the queue, and hands back a spare entry to fill.
+        Entry reserve(std::size_t bytes);
+        void enqueue(Entry entry);
+
+        void writeRecords(std::stop_token stop);
+        void writeRecord(Entry& entry);
+        void write(std::span<const uint8_t> bytes);
+
+        uint64_t _width;
+        uint64_t _height;
+        uint64_t _keyframeInterval;
+        std::ofstream _file;
+
+        std::vector<BandDelta> _bands;
+
+        // Only touched by the writer thread: the world as of the last record, one bit per cell,
+        // so keyframes are packed here rather than copied out of the simulation.
+        std::vector<uint8_t> _world;
+        uint64_t _previousNumber{};
+        bool _hasPrevious = false;
+        std::vector<uint8_t> _encoded;
+
+        std::deque<Entry> _queue, _spare;
+        std::size_t _queuedBytes{};
+        std::mutex _queueLock;
+        std::condition_variable_any _queueCondition, _spaceCondition;
+
+        std::atomic<uint64_t> _bytesWritten = 0u;
+        std::atomic<bool> _failed = false;
+
+        // Last, so the writer is joined before anything it uses is destroyed.
+        std::jthread _writer;
+    };
+
+    /*
+        Reads a log written by LogWriter. Opening it scans the records once to find the
+        keyframes; seeking then loads the nearest keyframe at or before the target and
+        applies the deltas from there. A log cut short, e.g. by a crash, ends at its last
+        complete record.
+    */
+    class LogReader
+    {
+    public:
+        struct Header
+        {
+            uint64_t width{};
+            uint64_t height{};
+            uint64_t keyframeInterval{};
+        };
+
+        // Reads only the header. Throws std::runtime_error if the file is not a generation log.
+        [[nodiscard]] static Header readHeader(const std::string& path);
+
+        // Opens the log at its first generation. Throws std::runtime_error if it is not a valid log.
+        explicit LogReader(const std::string& path);
+
+        [[nodiscard]] const Header& header() const noexcept { return _header; }
+        [[nodiscard]] uint64_t firstGeneration() const noexcept { return _keyframes.front().first; }
+        [[nodiscard]] uint64_t lastGeneration() const noexcept { return _lastGeneration; }
+
+        // Moves to the given generation, clamped to the recorded range.
+        void seek(uint64_t generation);
+
+        // Moves to the next generation. Returns false at the end of the log.
+        bool next();
+
+        // The world at the current generation. Ages are not logged.
+        [[nodiscard]] const Generation& current() const noexcept { return _current; }
+
+    private:
+        enum class Record : uint8_t { End, Keyframe, Delta };
+
+        Record readRecord(bool apply);
+
+        Header _header;
+        std::ifstream _file;
+        std::streamoff _fileSize{};
+
+        // Generation number and file offset of every keyframe, in order.
+        std::vector<std::pair<uint64_t, std::streamoff>> _keyframes;
+        uint64_t _lastGeneration{};
+
+        Generation _current;
+        bool _loaded = false;
+        uint64_t _recordNumber{};
+        std::vector<uint8_t> _payload;
+    };
+}
+
+#endif
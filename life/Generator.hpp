@@ -0,0 +1,122 @@
+#ifndef LIFE_GENERATOR_HPP
+#define LIFE_GENERATOR_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace life
+{
+    /*
+        A coroutine that yields values of T one at a time, pulled with a range-for loop. It
+        does nothing until the first value is asked for, and runs only as far as the next
+        co_yield each time. Destroying it part way through destroys the coroutine's frame, so
+        its locals are cleaned up as if it had returned.
+
+        The subset of std::generator the engine needs, which not every standard library has yet.
+    */
+    template<typename T>
+    class Generator
+    {
+    public:
+        struct promise_type
+        {
+            // Points at the operand of the last co_yield, which lives until the coroutine is resumed.
+            const T* value = nullptr;
+            std::exception_ptr exception;
+
+            Generator get_return_object() noexcept { return Generator{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_always final_suspend() const noexcept { return {}; }
+
+            std::suspend_always yield_value(const T& yielded) noexcept
+            {
+                value = std::addressof(yielded);
+                return {};
+            }
+
+            void return_void() const noexcept {}
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+            // co_await has no meaning inside a generator.
+            void await_transform() = delete;
+        };
+
+        using Handle = std::coroutine_handle<promise_type>;
+
+        class Iterator
+        {
+        public:
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+            explicit Iterator(Handle coroutine) noexcept : _coroutine{ coroutine } {}
+
+            [[nodiscard]] const T& operator*() const noexcept { return *_coroutine.promise().value; }
+            [[nodiscard]] const T* operator->() const noexcept { return _coroutine.promise().value; }
+
+            Iterator& operator++()
+            {
+                resume(_coroutine);
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            [[nodiscard]] bool operator==(std::default_sentinel_t) const noexcept { return _coroutine.done(); }
+
+        private:
+            Handle _coroutine;
+        };
+
+        Generator() = default;
+        ~Generator() { if(_coroutine) { _coroutine.destroy(); } }
+
+        Generator(const Generator&) = delete;
+        Generator& operator=(const Generator&) = delete;
+
+        Generator(Generator&& other) noexcept : _coroutine{ std::exchange(other._coroutine, {}) } {}
+
+        Generator& operator=(Generator&& other) noexcept
+        {
+            if(this != &other)
+            {
+                if(_coroutine) { _coroutine.destroy(); }
+                _coroutine = std::exchange(other._coroutine, {});
+            }
+
+            return *this;
+        }
+
+        // Runs the coroutine to its first co_yield. Can only be called once.
+        [[nodiscard]] Iterator begin()
+        {
+            resume(_coroutine);
+            return Iterator{ _coroutine };
+        }
+
+        [[nodiscard]] std::default_sentinel_t end() const noexcept { return {}; }
+
+    private:
+        explicit Generator(Handle coroutine) noexcept : _coroutine{ coroutine } {}
+
+        // Runs the coroutine to its next co_yield, or its end, rethrowing whatever escaped from it.
+        static void resume(Handle coroutine)
+        {
+            coroutine.resume();
+
+            if(coroutine.promise().exception)
+            {
+                std::rethrow_exception(std::exchange(coroutine.promise().exception, {}));
+            }
+        }
+
+        Handle _coroutine;
+    };
+}
+
+#endif
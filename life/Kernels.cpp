@@ -0,0 +1,245 @@
+#include <Kernels.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace life
+{
+	namespace
+	{
+		// Cells and ages are worked on as plain bytes.
+		const uint8_t* bytes(const CellBuffer& cells) noexcept { return reinterpret_cast<const uint8_t*>(cells.data()); }
+		uint8_t* bytes(CellBuffer& cells) noexcept { return reinterpret_cast<uint8_t*>(cells.data()); }
+
+		// Stands in for the rows above the first and below the last.
+		constexpr std::array<uint8_t, maxTileWidth + 2uz> deadRow{};
+
+		/*
+			The loops below work on blocks copied into local arrays. The compiler then knows
+			the blocks can't overlap, and vectorizes them with no runtime alias checks.
+		*/
+		constexpr auto blockSize = 32uz;
+		using Block = std::array<uint8_t, blockSize>;
+
+		void sumColumns(const uint8_t* above, const uint8_t* middle, const uint8_t* below, uint8_t* sums, std::size_t count) noexcept
+		{
+			auto i = 0uz;
+			for (; i + blockSize <= count; i += blockSize)
+			{
+				Block a, m, b, s;
+				std::memcpy(a.data(), above + i, blockSize);
+				std::memcpy(m.data(), middle + i, blockSize);
+				std::memcpy(b.data(), below + i, blockSize);
+
+				for (auto k = 0uz; k < blockSize; ++k) { s[k] = static_cast<uint8_t>(a[k] + m[k] + b[k]); }
+
+				std::memcpy(sums + i, s.data(), blockSize);
+			}
+
+			for (; i < count; ++i) { sums[i] = static_cast<uint8_t>(above[i] + middle[i] + below[i]); }
+		}
+
+		// A cell's own column sum includes the cell, so it is taken off again.
+		uint8_t applyRule(uint8_t left, uint8_t centre, uint8_t right, uint8_t self) noexcept
+		{
+			const auto neighbours = static_cast<uint8_t>(left + centre + right - self);
+			return static_cast<uint8_t>((neighbours == 3u) | ((neighbours == 2u) & self));
+		}
+
+		void applyRule(const uint8_t* columns, const uint8_t* self, uint8_t* next, std::size_t count) noexcept
+		{
+			auto i = 0uz;
+			for (; i + blockSize <= count; i += blockSize)
+			{
+				Block left, centre, right, cells, result;
+				std::memcpy(left.data(), columns + i, blockSize);
+				std::memcpy(centre.data(), columns + i + 1u, blockSize);
+				std::memcpy(right.data(), columns + i + 2u, blockSize);
+				std::memcpy(cells.data(), self + i, blockSize);
+
+				for (auto k = 0uz; k < blockSize; ++k) { result[k] = applyRule(left[k], centre[k], right[k], cells[k]); }
+
+				std::memcpy(next + i, result.data(), blockSize);
+			}
+
+			for (; i < count; ++i) { next[i] = applyRule(columns[i], columns[i + 1u], columns[i + 2u], self[i]); }
+		}
+
+		uint8_t nextAge(uint8_t age, uint8_t before, uint8_t after) noexcept
+		{
+			const auto older = static_cast<uint8_t>(std::min(age, uint8_t{254}) + 1u);
+			return (before == after) ? older : uint8_t{};
+		}
+
+		void updateAges(const uint8_t* previousAge, const uint8_t* self, const uint8_t* next, uint8_t* age, std::size_t count) noexcept
+		{
+			auto i = 0uz;
+			for (; i + blockSize <= count; i += blockSize)
+			{
+				Block ages, before, after, result;
+				std::memcpy(ages.data(), previousAge + i, blockSize);
+				std::memcpy(before.data(), self + i, blockSize);
+				std::memcpy(after.data(), next + i, blockSize);
+
+				for (auto k = 0uz; k < blockSize; ++k) { result[k] = nextAge(ages[k], before[k], after[k]); }
+
+				std::memcpy(age + i, result.data(), blockSize);
+			}
+
+			for (; i < count; ++i) { age[i] = nextAge(previousAge[i], self[i], next[i]); }
+		}
+
+		// stepTiled() on plain bytes, so it can step the world as well as stepTemporal()'s tiles.
+		template<bool TrackAges>
+		void stepTiles(const uint8_t* source, uint8_t* target, const uint8_t* fromAges, uint8_t* toAges, uint64_t width, uint64_t height,
+			uint64_t firstRow, uint64_t lastRow, uint64_t tileWidth) noexcept
+		{
+			tileWidth = std::clamp(tileWidth, uint64_t{1}, maxTileWidth);
+
+			// Column sums of the tile, with one extra column on either side.
+			std::array<uint8_t, maxTileWidth + 2uz> columns;
+
+			for (auto tileStart = 0uz; tileStart < width; tileStart += tileWidth)
+			{
+				const auto tileEnd = std::min(tileStart + tileWidth, width);
+				const auto tileSize = tileEnd - tileStart;
+
+				// The columns beside the tile, where they exist.
+				const auto sumsStart = tileStart - ((tileStart > 0u) ? 1u : 0u);
+				const auto sumsEnd = tileEnd + ((tileEnd < width) ? 1u : 0u);
+				auto* sums = columns.data() + 1u - (tileStart - sumsStart);
+
+				for (auto y = firstRow; y < lastRow; ++y)
+				{
+					const auto* above = (y > 0u) ? source + ((y - 1u) * width) + sumsStart : deadRow.data();
+					const auto* middle = source + (y * width) + sumsStart;
+					const auto* below = (y + 1u < height) ? source + ((y + 1u) * width) + sumsStart : deadRow.data();
+
+					columns[0] = 0u;
+					columns[tileSize + 1u] = 0u;
+					sumColumns(above, middle, below, sums, sumsEnd - sumsStart);
+
+					const auto rowStart = (y * width) + tileStart;
+					applyRule(columns.data(), source + rowStart, target + rowStart, tileSize);
+
+					if constexpr (TrackAges)
+					{
+						updateAges(fromAges + rowStart, source + rowStart, target + rowStart, toAges + rowStart, tileSize);
+					}
+				}
+			}
+		}
+
+		// Side of the largest tile with its halo. Nothing beyond the world's edges is copied, those cells are dead anyway.
+		uint64_t haloSide(uint64_t width, uint64_t height, uint64_t generations, uint64_t tileSize) noexcept
+		{
+			return std::min(tileSize + (2u * generations), std::max(width, height));
+		}
+	}
+
+	uint64_t autoTileWidth()
+	{
+		uint64_t cacheSize = 32u * 1024u;
+
+#if defined(__linux__) && defined(_SC_LEVEL1_DCACHE_SIZE)
+		if (const auto reported = sysconf(_SC_LEVEL1_DCACHE_SIZE); reported > 0)
+		{
+			cacheSize = static_cast<uint64_t>(reported);
+		}
+#endif
+
+		// Each column of a tile holds three input rows, the output row, the column sums and, with ages,
+		// two more rows. Using half the cache for them leaves room for everything else.
+		constexpr uint64_t bytesPerColumn = 8u;
+		return std::clamp(cacheSize / 2u / bytesPerColumn / 64u * 64u, uint64_t{64}, maxTileWidth);
+	}
+
+	uint64_t autoTemporalTile(uint64_t generations)
+	{
+		uint64_t cacheSize = 256u * 1024u;
+
+#if defined(__linux__) && defined(_SC_LEVEL2_CACHE_SIZE)
+		if (const auto reported = sysconf(_SC_LEVEL2_CACHE_SIZE); reported > 0)
+		{
+			cacheSize = static_cast<uint64_t>(reported);
+		}
+#endif
+
+		// Two buffers of a byte per cell in half the cache, but never so small the halo dwarfs the tile.
+		const auto side = static_cast<uint64_t>(std::sqrt(static_cast<double>(cacheSize / 4u)));
+		return std::max(side - std::min(side, 2u * generations), 4u * generations);
+	}
+
+	TemporalScratch::TemporalScratch(uint64_t width, uint64_t height, uint64_t generations, uint64_t tileSize)
+	{
+		const auto side = haloSide(width, height, std::clamp(generations, uint64_t{1}, maxGenerationsPerPass), std::max(tileSize, uint64_t{1}));
+
+		current.resize(side * side);
+		next.resize(side * side);
+	}
+
+	void stepTemporal(const Generation& from, Generation& to, uint64_t width, uint64_t height,
+		uint64_t firstRow, uint64_t lastRow, uint64_t generations, uint64_t tileSize, TemporalScratch& scratch)
+	{
+		generations = std::clamp(generations, uint64_t{1}, maxGenerationsPerPass);
+		tileSize = std::max(tileSize, uint64_t{1});
+
+		if (const auto side = haloSide(width, height, generations, tileSize); scratch.current.size() < side * side)
+		{
+			scratch.current.resize(side * side);
+			scratch.next.resize(side * side);
+		}
+
+		const auto* source = bytes(from.cells);
+		auto* target = bytes(to.cells);
+		auto* current = scratch.current.data();
+		auto* next = scratch.next.data();
+
+		for (auto tileTop = firstRow; tileTop < lastRow; tileTop += tileSize)
+		{
+			const auto tileBottom = std::min(tileTop + tileSize, lastRow);
+			const auto top = tileTop - std::min(tileTop, generations);
+			const auto bottom = std::min(tileBottom + generations, height);
+
+			for (auto tileLeft = 0uz; tileLeft < width; tileLeft += tileSize)
+			{
+				const auto tileRight = std::min(tileLeft + tileSize, width);
+				const auto left = tileLeft - std::min(tileLeft, generations);
+				const auto right = std::min(tileRight + generations, width);
+				const auto haloWidth = right - left;
+				const auto haloHeight = bottom - top;
+
+				for (auto y = top; y < bottom; ++y)
+				{
+					std::memcpy(current + ((y - top) * haloWidth), source + (y * width) + left, haloWidth);
+				}
+
+				for (auto i = 0uz; i < generations; ++i)
+				{
+					stepTiles<false>(current, next, nullptr, nullptr, haloWidth, haloHeight, 0u, haloHeight, haloWidth);
+					std::swap(current, next);
+				}
+
+				for (auto y = tileTop; y < tileBottom; ++y)
+				{
+					std::memcpy(target + (y * width) + tileLeft, current + ((y - top) * haloWidth) + (tileLeft - left), tileRight - tileLeft);
+				}
+			}
+		}
+	}
+
+	template<bool TrackAges>
+	void stepTiled(const Generation& from, Generation& to, uint64_t width, uint64_t height,
+		uint64_t firstRow, uint64_t lastRow, uint64_t tileWidth) noexcept
+	{
+		stepTiles<TrackAges>(bytes(from.cells), bytes(to.cells), from.ages.data(), to.ages.data(), width, height, firstRow, lastRow, tileWidth);
+	}
+
+	template void stepTiled<false>(const Generation&, Generation&, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) noexcept;
+	template void stepTiled<true>(const Generation&, Generation&, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) noexcept;
+}
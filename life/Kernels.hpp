@@ -0,0 +1,75 @@
+#ifndef LIFE_KERNELS_HPP
+#define LIFE_KERNELS_HPP
+
+#include <Generation.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace life
+{
+    // The ways the simulation can compute a generation. They all give identical results.
+    enum class Kernel : uint8_t
+    {
+        Reference,  // Simulation::countNeighbors() for every cell, row by row across the whole world.
+        Tiled       // Column tiles that fit in the L1 cache, see stepTiled().
+    };
+
+    // Widest tile stepTiled() accepts, in cells.
+    constexpr uint64_t maxTileWidth = 65536u;
+
+    // Tile width for this machine's L1 data cache, falling back to a 32 KiB cache if its size is unknown.
+    [[nodiscard]] uint64_t autoTileWidth();
+
+    /*
+        Computes rows firstRow to lastRow of the next generation, treating cells beyond the
+        edges of the world as dead. The band is split into column tiles of tileWidth cells,
+        each worked through from top to bottom, so the three input rows a cell's neighbours
+        come from are still in the L1 cache when the next row needs two of them again. Each
+        input row is then fetched from memory once per generation, however wide the world.
+
+        Within a row, the cells of each column are summed first, then each cell adds up its
+        own column and the two beside it. Both passes are branchless and vectorize.
+    */
+    template<bool TrackAges>
+    void stepTiled(const Generation& from, Generation& to, uint64_t width, uint64_t height,
+        uint64_t firstRow, uint64_t lastRow, uint64_t tileWidth) noexcept;
+
+    // Largest number of generations stepTemporal() advances in one pass.
+    constexpr uint64_t maxGenerationsPerPass = 64u;
+
+    // Side of the square tiles stepTemporal() uses, so a tile and its halo fit the L2 cache twice over.
+    [[nodiscard]] uint64_t autoTemporalTile(uint64_t generations);
+
+    // Where stepTemporal() steps a tile with its halo. Plain vectors rather than world buffers:
+    // a tile only ever lives in the cache, so huge pages or placement would gain nothing.
+    struct TemporalScratch
+    {
+        TemporalScratch() = default;
+
+        // Sized for stepTemporal() with these arguments, so it never has to grow.
+        TemporalScratch(uint64_t width, uint64_t height, uint64_t generations, uint64_t tileSize);
+
+        std::vector<uint8_t> current;
+        std::vector<uint8_t> next;
+    };
+
+    /*
+        Like stepTiled(), but advances rows firstRow to lastRow by several generations at once.
+        Each tile is copied, along with a halo as wide as the number of generations, into a
+        small buffer that stays in the L2 cache. It is stepped there again and again, and only
+        then is its middle written out. Mistakes creep in from the edges of the halo, where
+        the cells beyond it are unknown, one cell per generation, so they never reach the
+        middle. The world streams through memory once per pass instead of once per generation,
+        at the cost of computing each halo along with its tile.
+
+        The tiles are stepped in scratch, which is grown if it is too small, so keeping one per
+        thread across passes saves allocating it every time. Ages are not supported.
+    */
+    void stepTemporal(const Generation& from, Generation& to, uint64_t width, uint64_t height,
+        uint64_t firstRow, uint64_t lastRow, uint64_t generations, uint64_t tileSize, TemporalScratch& scratch);
+
+    extern template void stepTiled<false>(const Generation&, Generation&, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) noexcept;
+    extern template void stepTiled<true>(const Generation&, Generation&, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) noexcept;
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include <Metrics.hpp>
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <fmt/format.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define LIFE_HAS_SOCKETS 1
+#endif
+
+namespace life
+{
+	namespace
+	{
+		void appendMetric(std::string& text, std::string_view name, std::string_view type, std::string_view help, double value)
+		{
+			text += fmt::format("# HELP {} {}\n# TYPE {} {}\n{} {}\n", name, help, name, type, name, value);
+		}
+
+		double seconds(std::chrono::nanoseconds time)
+		{
+			return std::chrono::duration<double>{ time }.count();
+		}
+	}
+
+	std::string formatMetrics(const MetricsSample& sample)
+	{
+		std::string text;
+
+		appendMetric(text, "life_generations_total", "counter", "Generations computed since start.", static_cast<double>(sample.generations));
+		appendMetric(text, "life_cells_total", "counter", "Cell updates computed since start.", static_cast<double>(sample.cells));
+		appendMetric(text, "life_population", "gauge", "Live cells in the last sampled generation.", static_cast<double>(sample.population));
+		appendMetric(text, "life_workers", "gauge", "Simulation worker threads.", static_cast<double>(sample.workers));
+		appendMetric(text, "life_compute_seconds_total", "counter", "Time the workers spent computing, summed over workers.", seconds(sample.compute));
+		appendMetric(text, "life_barrier_wait_seconds_total", "counter", "Time the workers spent at the generation barrier, summed over workers.", seconds(sample.barrierWait));
+		appendMetric(text, "life_render_seconds_total", "counter", "Time spent drawing frames.", seconds(sample.render));
+		appendMetric(text, "life_frames_total", "counter", "Frames drawn since start.", static_cast<double>(sample.frames));
+		appendMetric(text, "process_resident_memory_bytes", "gauge", "Resident memory size in bytes.", static_cast<double>(sample.residentBytes));
+
+		return text;
+	}
+
+	uint64_t residentBytes()
+	{
+#if defined(__linux__)
+		// The second field is the resident set, in pages.
+		std::FILE* statm = std::fopen("/proc/self/statm", "r");
+		if (statm == nullptr) { return 0u; }
+
+		unsigned long long size = 0u, resident = 0u;
+		const auto fields = std::fscanf(statm, "%llu %llu", &size, &resident);
+		std::fclose(statm);
+
+		const auto pageSize = sysconf(_SC_PAGESIZE);
+		return (fields == 2 && pageSize > 0) ? resident * static_cast<uint64_t>(pageSize) : 0u;
+#else
+		return 0u;
+#endif
+	}
+
+#if defined(LIFE_HAS_SOCKETS)
+	MetricsServer::MetricsServer(uint16_t port, Collect collect) : _collect(std::move(collect))
+	{
+		_listener = socket(AF_INET, SOCK_STREAM, 0);
+		if (_listener < 0)
+		{
+			throw std::runtime_error{ fmt::format("Can't create the metrics socket (errno {})", errno) };
+		}
+
+		const int reuse = 1;
+		setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t length = sizeof(address);
+
+		if (bind(_listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(_listener, 8) != 0
+			|| getsockname(_listener, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+		{
+			const auto error = errno;
+			close(_listener);
+			throw std::runtime_error{ fmt::format("Can't serve metrics on port {} (errno {})", port, error) };
+		}
+
+		_port = ntohs(address.sin_port);
+		_server = std::jthread{ [this](std::stop_token stop){ serve(stop); } };
+	}
+
+	MetricsServer::~MetricsServer()
+	{
+		_server.request_stop();
+		if (_server.joinable()) { _server.join(); }
+
+		close(_listener);
+	}
+
+	void MetricsServer::serve(std::stop_token stop)
+	{
+		// Wakes up now and then to notice the stop request, there is no way to interrupt accept().
+		constexpr int pollMilliseconds = 200;
+
+		while (!stop.stop_requested())
+		{
+			pollfd listener{ .fd=_listener, .events=POLLIN, .revents=0 };
+			if (poll(&listener, 1, pollMilliseconds) <= 0) { continue; }
+
+			const int connection = accept(_listener, nullptr, nullptr);
+			if (connection < 0) { continue; }
+
+			answer(connection);
+			close(connection);
+		}
+	}
+
+	void MetricsServer::answer(int connection)
+	{
+		// A scraper that stops talking can't hold the server up for long.
+		const timeval timeout{ .tv_sec=1, .tv_usec=0 };
+		setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		// Only the request line matters; the rest of the request is read until the blank line and ignored.
+		std::array<char, 4096> buffer{};
+		std::size_t received = 0u;
+		while (received < buffer.size() && std::string_view{ buffer.data(), received }.find("\r\n\r\n") == std::string_view::npos)
+		{
+			const auto count = recv(connection, buffer.data() + received, buffer.size() - received, 0);
+			if (count <= 0) { break; }
+			received += static_cast<std::size_t>(count);
+		}
+
+		const std::string_view request{ buffer.data(), received };
+		const bool found = request.starts_with("GET /metrics ") || request.starts_with("GET / ");
+
+		const auto body = found ? formatMetrics(_collect()) : std::string{ "Not found\n" };
+		const auto response = fmt::format("HTTP/1.1 {}\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+			found ? "200 OK" : "404 Not Found", body.size(), body);
+
+		std::string_view remaining{ response };
+		while (!remaining.empty())
+		{
+			const auto sent = send(connection, remaining.data(), remaining.size(), MSG_NOSIGNAL);
+			if (sent <= 0) { break; }
+			remaining.remove_prefix(static_cast<std::size_t>(sent));
+		}
+
+		if (found) { ++_served; }
+	}
+#else
+	MetricsServer::MetricsServer(uint16_t /*port*/, Collect collect) : _collect(std::move(collect))
+	{
+		throw std::runtime_error{ "The metrics endpoint is not supported on this platform" };
+	}
+
+	MetricsServer::~MetricsServer() = default;
+	void MetricsServer::serve(std::stop_token /*stop*/) {}
+	void MetricsServer::answer(int /*connection*/) {}
+#endif
+}
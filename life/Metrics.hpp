@@ -0,0 +1,69 @@
+#ifndef LIFE_METRICS_HPP
+#define LIFE_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+namespace life
+{
+    // One reading of every exported metric, taken when a scrape arrives.
+    struct MetricsSample
+    {
+        uint64_t generations{};
+        uint64_t cells{};
+        uint64_t population{};
+        uint64_t workers{};
+        std::chrono::nanoseconds compute{};
+        std::chrono::nanoseconds barrierWait{};
+        std::chrono::nanoseconds render{};
+        uint64_t frames{};
+        uint64_t residentBytes{};
+    };
+
+    // The sample in the Prometheus text exposition format, version 0.0.4.
+    [[nodiscard]] std::string formatMetrics(const MetricsSample& sample);
+
+    // Resident set size of this process, zero where unknown.
+    [[nodiscard]] uint64_t residentBytes();
+
+    /*
+        Serves GET /metrics over HTTP on a local port, from its own thread. The sample is only
+        taken when a scrape arrives, so between scrapes this costs nothing but a sleeping thread.
+        Throws std::runtime_error if the port can't be bound.
+    */
+    class MetricsServer
+    {
+    public:
+        using Collect = std::function<MetricsSample()>;
+
+        // Listens on 127.0.0.1 only. Port zero picks a free one, see port().
+        MetricsServer(uint16_t port, Collect collect);
+        ~MetricsServer();
+
+        MetricsServer(const MetricsServer&) = delete;
+        MetricsServer& operator=(const MetricsServer&) = delete;
+        MetricsServer(MetricsServer&&) = delete;
+        MetricsServer& operator=(MetricsServer&&) = delete;
+
+        [[nodiscard]] uint16_t port() const noexcept { return _port; }
+        [[nodiscard]] uint64_t served() const noexcept { return _served; }
+
+    private:
+        void serve(std::stop_token stop);
+        void answer(int connection);
+
+        Collect _collect;
+        int _listener = -1;
+        uint16_t _port{};
+        std::atomic<uint64_t> _served = 0u;
+
+        std::jthread _server;
+    };
+}
+
+#endif
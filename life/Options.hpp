@@ -0,0 +1,89 @@
+#ifndef LIFE_OPTIONS_HPP
+#define LIFE_OPTIONS_HPP
+
+#include <Kernels.hpp>
+#include <WorldBuffer.hpp>
+#include <cstdint>
+#include <string>
+
+namespace life
+{
+    // Settings chosen on the command line, see main.cpp.
+    struct Options
+    {
+        uint64_t worldWidth = 256u;
+        uint64_t worldHeight = 192u;
+
+        // Initial size of a cell on screen, in pixels.
+        uint64_t cellSize = 1u;
+
+        // Runs with the same seed and density start from the same world.
+        uint64_t seed{};
+        double density = 0.5;
+
+        // Pin the simulation's workers to CPUs, spread evenly over the NUMA nodes.
+        bool pinThreads = false;
+
+        // How generations are computed, and the tile width for the tiled kernel, zero to fit the L1 cache.
+        Kernel kernel = Kernel::Tiled;
+        uint64_t tileWidth{};
+
+        // Passes between moving the workers' band boundaries to even out their compute time, zero for fixed bands.
+        uint64_t rebalanceEvery{};
+
+        // Generations computed per pass over the world, by temporal blocking.
+        uint64_t generationsPerPass = 1u;
+
+        // How large world buffers are backed.
+        HugePages hugePages = HugePages::Transparent;
+
+        // Measure how evenly the work is spread over the workers, shown in the HUD and reported at exit.
+        bool profileLoad = false;
+
+        // Count hardware events around the step kernel and report them per cell at exit.
+        bool countEvents = false;
+
+        // Track how long each cell has kept its state, and colour the world by it.
+        bool heatmap = false;
+
+        // Target generations per second, zero for unlimited.
+        double generationsPerSecond{};
+
+        // Where to stream the rendered frames, "-" for stdout. Empty if not recording.
+        std::string recordPath;
+
+        // Where to log every generation, and how many generations apart the keyframes are. Empty if not logging.
+        std::string logPath;
+        uint64_t keyframeInterval = 1000u;
+
+        // Generations between checkpoints, zero for none. A checkpoint is also written on SIGTERM.
+        uint64_t checkpointEvery{};
+        std::string checkpointPath = "life.checkpoint";
+
+        // A checkpoint to continue from instead of a random world. Empty to start afresh.
+        std::string resumePath;
+
+        // Shared-memory segment the simulation computes its generations in, for other processes. Empty if not sharing.
+        std::string shareName;
+
+        // Local port to serve Prometheus metrics on, zero for none.
+        uint16_t metricsPort{};
+
+        // Where to write a Chrome trace of every thread's phases at exit. Empty if not tracing.
+        std::string tracePath;
+
+        // A checkpoint to print the census of, without opening the window. Empty to run the game.
+        std::string censusPath;
+
+        // A log to play back instead of running a simulation. Empty if not replaying.
+        std::string replayPath;
+
+        // Processes to split a headless run over, zero to open the window instead. The run
+        // stops after the given number of generations and may save the last one as a checkpoint.
+        uint64_t processes{};
+        uint64_t generations = 1000u;
+        std::string outputPath;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include <PerfCounters.hpp>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace life
+{
+	PerfCounts& PerfCounts::operator+=(const PerfCounts& other) noexcept
+	{
+		for (auto i = 0uz; i < perfEventCount; ++i)
+		{
+			values[i] = (values[i] < 0 || other.values[i] < 0) ? -1 : values[i] + other.values[i];
+		}
+
+		cells += other.cells;
+		return *this;
+	}
+
+#if defined(__linux__)
+	namespace
+	{
+		constexpr std::array<std::pair<uint32_t, uint64_t>, perfEventCount> eventTypes
+		{{
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+			{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8u) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u) },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+		}};
+
+		int openEvent(uint32_t type, uint64_t config, int leader)
+		{
+			perf_event_attr attributes{};
+			attributes.size = sizeof(attributes);
+			attributes.type = type;
+			attributes.config = config;
+			attributes.exclude_kernel = 1u;
+			attributes.exclude_hv = 1u;
+			attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			// The rest of the group follows the leader, which starts switched off.
+			if (leader < 0) { attributes.disabled = 1u; }
+
+			// This thread, on whichever CPU it runs.
+			return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, leader, 0ul));
+		}
+	}
+
+	PerfCounters::PerfCounters() noexcept
+	{
+		for (auto i = 0uz; i < perfEventCount; ++i)
+		{
+			_events[i] = openEvent(eventTypes[i].first, eventTypes[i].second, _events[0]);
+
+			// Without cycles there is nothing to relate the rest to.
+			if (i == 0uz && _events[0] < 0) { return; }
+		}
+	}
+
+	PerfCounters::~PerfCounters()
+	{
+		// Members before the leader.
+		for (auto i = perfEventCount; i-- > 0uz;)
+		{
+			if (_events[i] >= 0) { close(_events[i]); }
+		}
+	}
+
+	void PerfCounters::resume() noexcept
+	{
+		if (available()) { ioctl(_events[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP); }
+	}
+
+	void PerfCounters::pause() noexcept
+	{
+		if (available()) { ioctl(_events[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP); }
+	}
+
+	PerfCounts PerfCounters::read() const noexcept
+	{
+		PerfCounts counts;
+
+		for (auto i = 0uz; i < perfEventCount; ++i)
+		{
+			struct { uint64_t value, enabled, running; } reading{};
+
+			if (_events[i] < 0 || ::read(_events[i], &reading, sizeof(reading)) != static_cast<ssize_t>(sizeof(reading)) || reading.running == 0u)
+			{
+				continue;
+			}
+
+			const auto scale = static_cast<double>(reading.enabled) / static_cast<double>(reading.running);
+			counts.values[i] = static_cast<int64_t>(static_cast<double>(reading.value) * scale);
+		}
+
+		return counts;
+	}
+#else
+	PerfCounters::PerfCounters() noexcept = default;
+	PerfCounters::~PerfCounters() = default;
+	void PerfCounters::resume() noexcept {}
+	void PerfCounters::pause() noexcept {}
+	PerfCounts PerfCounters::read() const noexcept { return PerfCounts{}; }
+#endif
+}
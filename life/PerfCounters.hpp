@@ -0,0 +1,67 @@
+#ifndef LIFE_PERFCOUNTERS_HPP
+#define LIFE_PERFCOUNTERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace life
+{
+    // Hardware events counted around the step kernel.
+    enum class PerfEvent : uint8_t
+    {
+        Cycles,
+        Instructions,
+        L1Misses,           // L1 data cache read misses.
+        LastLevelMisses,    // Usually last-level cache misses; the kernel maps it per CPU.
+        BranchMisses
+    };
+
+    constexpr auto perfEventCount = 5uz;
+
+    struct PerfCounts
+    {
+        // Negative where the event couldn't be counted.
+        std::array<int64_t, perfEventCount> values{ -1, -1, -1, -1, -1 };
+
+        // Cells stepped while counting, filled in by the caller.
+        uint64_t cells{};
+
+        [[nodiscard]] int64_t operator[](PerfEvent event) const noexcept { return values[static_cast<std::size_t>(event)]; }
+
+        // Adds another thread's counts. An event counts as missing if either side misses it.
+        PerfCounts& operator+=(const PerfCounts& other) noexcept;
+    };
+
+    /*
+        Counts the calling thread's hardware events, in user space only, using Linux's
+        perf_event_open. Starts paused. Opening never fails loudly: without permission
+        (see /proc/sys/kernel/perf_event_paranoid), on other platforms or in VMs without a
+        PMU, available() is false and nothing is counted.
+    */
+    class PerfCounters
+    {
+    public:
+        PerfCounters() noexcept;
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+        PerfCounters(PerfCounters&&) = delete;
+        PerfCounters& operator=(PerfCounters&&) = delete;
+
+        [[nodiscard]] bool available() const noexcept { return _events[0] >= 0; }
+
+        void resume() noexcept;
+        void pause() noexcept;
+
+        // Totals while resumed, scaled up if the kernel had to share the counters with others.
+        [[nodiscard]] PerfCounts read() const noexcept;
+
+    private:
+        // The first event leads the group, so all of them are switched on and off together.
+        std::array<int, perfEventCount> _events{ -1, -1, -1, -1, -1 };
+    };
+}
+
+#endif
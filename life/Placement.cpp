@@ -0,0 +1,114 @@
+#include <Placement.hpp>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace life
+{
+#if defined(__linux__)
+	namespace
+	{
+		// Parses the number following a prefix, e.g. 3 for "node3" after "node". Returns -1 if there is none.
+		int numberAfter(std::string_view name, std::string_view prefix)
+		{
+			if (!name.starts_with(prefix)) { return -1; }
+
+			name.remove_prefix(prefix.size());
+
+			int number = -1;
+			const auto [end, error] = std::from_chars(name.data(), name.data() + name.size(), number);
+
+			return (error == std::errc{} && end == name.data() + name.size()) ? number : -1;
+		}
+	}
+
+	int numaNodeCount()
+	{
+		std::error_code error;
+		int count = 0;
+
+		for (const auto& entry : std::filesystem::directory_iterator{ "/sys/devices/system/node", error })
+		{
+			if (numberAfter(entry.path().filename().string(), "node") >= 0) { ++count; }
+		}
+
+		return std::max(count, 1);
+	}
+
+	std::vector<int> usableCpus()
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+
+		if (sched_getaffinity(0, sizeof(set), &set) != 0) { return {}; }
+
+		std::vector<int> cpus;
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+		{
+			if (CPU_ISSET(static_cast<std::size_t>(cpu), &set)) { cpus.push_back(cpu); }
+		}
+
+		std::ranges::stable_sort(cpus, {}, [](int cpu) { return nodeOfCpu(cpu); });
+		return cpus;
+	}
+
+	bool pinCurrentThread(int cpu)
+	{
+		if (cpu < 0 || cpu >= CPU_SETSIZE) { return false; }
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(static_cast<std::size_t>(cpu), &set);
+
+		// Zero means the calling thread, not the whole process.
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+	}
+
+	int currentCpu()
+	{
+		return sched_getcpu();
+	}
+
+	int nodeOfCpu(int cpu)
+	{
+		std::error_code error;
+
+		// Each CPU's directory links to the node it belongs to.
+		for (const auto& entry : std::filesystem::directory_iterator{ "/sys/devices/system/cpu/cpu" + std::to_string(cpu), error })
+		{
+			const auto node = numberAfter(entry.path().filename().string(), "node");
+			if (node >= 0) { return node; }
+		}
+
+		return -1;
+	}
+
+	int nodeOfAddress(const void* address)
+	{
+		const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+		void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) & ~(pageSize - 1u));
+		int status = -1;
+
+		// Without target nodes, move_pages() only reports where each page is.
+		if (syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0) != 0) { return -1; }
+
+		return (status >= 0) ? status : -1;
+	}
+#else
+	int numaNodeCount() { return 1; }
+	std::vector<int> usableCpus() { return {}; }
+	bool pinCurrentThread(int /*cpu*/) { return false; }
+	int currentCpu() { return -1; }
+	int nodeOfCpu(int /*cpu*/) { return -1; }
+	int nodeOfAddress(const void* /*address*/) { return -1; }
+#endif
+}
@@ -0,0 +1,30 @@
+#ifndef LIFE_PLACEMENT_HPP
+#define LIFE_PLACEMENT_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace life
+{
+    /*
+        Where threads and memory ended up on a NUMA machine. Only Linux is supported; elsewhere
+        nothing can be pinned and every query answers -1, for unknown.
+    */
+
+    // Number of NUMA nodes, 1 if unknown.
+    [[nodiscard]] int numaNodeCount();
+
+    // CPUs this process may run on, ordered by NUMA node, so that neighbouring entries share a node.
+    [[nodiscard]] std::vector<int> usableCpus();
+
+    // Restricts the calling thread to one CPU. Returns false if that isn't possible.
+    bool pinCurrentThread(int cpu);
+
+    [[nodiscard]] int currentCpu();
+    [[nodiscard]] int nodeOfCpu(int cpu);
+
+    // NUMA node holding the page of an address that has already been written.
+    [[nodiscard]] int nodeOfAddress(const void* address);
+}
+
+#endif
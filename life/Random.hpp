@@ -0,0 +1,40 @@
+#ifndef LIFE_RANDOM_HPP
+#define LIFE_RANDOM_HPP
+
+#include <cstdint>
+
+namespace life
+{
+    /*
+        A counter-based random generator: the value for a counter depends only on the key and
+        the counter itself, so any part of the sequence can be produced on its own, in any order
+        and on any thread. Seeding cell i from counter i makes the world independent of how the
+        work is split up.
+    */
+    struct CounterRng
+    {
+        uint64_t key;
+
+        // The SplitMix64 output function, applied to a Weyl sequence offset by the mixed key.
+        [[nodiscard]] static constexpr uint64_t mix(uint64_t z) noexcept
+        {
+            z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31u);
+        }
+
+        [[nodiscard]] constexpr uint64_t operator()(uint64_t counter) const noexcept
+        {
+            return mix(mix(key) + ((counter + 1u) * 0x9E3779B97F4A7C15ull));
+        }
+
+        // True with the given probability. 53 bits are enough to represent any double in [0, 1].
+        [[nodiscard]] constexpr bool chance(uint64_t counter, double probability) const noexcept
+        {
+            constexpr auto scale = static_cast<double>(1ull << 53u);
+            return static_cast<double>((*this)(counter) >> 11u) < probability * scale;
+        }
+    };
+}
+
+#endif
\ No newline at end of file
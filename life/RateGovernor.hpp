@@ -0,0 +1,66 @@
+#ifndef LIFE_RATEGOVERNOR_HPP
+#define LIFE_RATEGOVERNOR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace life
+{
+    /*
+        Holds the simulation to a target number of generations per second. Most of each interval
+        is slept away, the last stretch is spun so the deadline is met precisely. A rate of zero
+        means unlimited: pace() returns immediately.
+    */
+    class RateGovernor
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit RateGovernor(double generationsPerSecond = 0.0) { setRate(generationsPerSecond); }
+
+        void setRate(double generationsPerSecond)
+        {
+            // Clamped before converting, tiny rates would overflow the clock's integer ticks.
+            _interval = (generationsPerSecond > 0.0)
+                ? std::chrono::duration_cast<Clock::duration>(std::min(std::chrono::duration<double>{ 1.0 / generationsPerSecond },
+                    std::chrono::duration<double>{ longestInterval }))
+                : Clock::duration::zero();
+            _next = Clock::now();
+        }
+
+        [[nodiscard]] bool unlimited() const noexcept { return _interval == Clock::duration::zero(); }
+
+        // Waits until the next generation is due.
+        void pace()
+        {
+            if(unlimited()) { return; }
+
+            _next += _interval;
+
+            const auto now = Clock::now();
+
+            // Don't try to catch up after falling behind, e.g. while paused.
+            if(_next < now)
+            {
+                _next = now;
+                return;
+            }
+
+            if(_next - now > spinTime) { std::this_thread::sleep_until(_next - spinTime); }
+            while(Clock::now() < _next) { std::this_thread::yield(); }
+        }
+
+    private:
+        // Sleeping is only accurate to roughly a scheduler tick.
+        static constexpr auto spinTime = std::chrono::microseconds{ 1500 };
+
+        // The slowest rate honoured: one generation a day.
+        static constexpr auto longestInterval = std::chrono::hours{ 24 };
+
+        Clock::duration _interval{};
+        Clock::time_point _next{};
+    };
+}
+
+#endif
\ No newline at end of file
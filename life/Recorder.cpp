@@ -0,0 +1,187 @@
+#include <Recorder.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+#include <fmt/format.h>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace life
+{
+	namespace
+	{
+		struct Rgb
+		{
+			int r, g, b;
+		};
+
+		// olc::Pixel keeps its channels in memory order R, G, B, A.
+		Rgb unpack(uint32_t pixel) noexcept
+		{
+			return Rgb{ .r=static_cast<int>(pixel & 0xFFu), .g=static_cast<int>((pixel >> 8u) & 0xFFu), .b=static_cast<int>((pixel >> 16u) & 0xFFu) };
+		}
+
+		// BT.601 studio range, in fixed point.
+		uint8_t luma(Rgb c) noexcept { return static_cast<uint8_t>((((66 * c.r) + (129 * c.g) + (25 * c.b) + 128) >> 8) + 16); }
+		uint8_t chromaBlue(Rgb c) noexcept { return static_cast<uint8_t>((((-38 * c.r) - (74 * c.g) + (112 * c.b) + 128) >> 8) + 128); }
+		uint8_t chromaRed(Rgb c) noexcept { return static_cast<uint8_t>((((112 * c.r) - (94 * c.g) - (18 * c.b) + 128) >> 8) + 128); }
+	}
+
+	Recorder::Recorder(const std::string& path, uint64_t width, uint64_t height, double framesPerSecond)
+		: _width(width), _height(height),
+		_format(path.ends_with(".ppm") ? VideoFormat::PPM : VideoFormat::Y4M)
+	{
+		if (path == "-")
+		{
+			_file = stdout;
+#if defined(_WIN32)
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		}
+		else
+		{
+			_file = std::fopen(path.c_str(), "wb");
+		}
+
+		if (_file == nullptr)
+		{
+			throw std::runtime_error{ fmt::format("Can't open '{}' for recording", path) };
+		}
+
+		if (_format == VideoFormat::Y4M)
+		{
+			// The rate is a fraction, e.g. 2.5 frames per second is F5:2.
+			const auto millihertz = std::max(uint64_t{1}, static_cast<uint64_t>(std::llround(framesPerSecond * 1000.0)));
+			const auto divisor = std::gcd(millihertz, uint64_t{1000});
+			fmt::print(_file, "YUV4MPEG2 W{} H{} F{}:{} Ip A1:1 C444\n", width, height, millihertz / divisor, 1000u / divisor);
+		}
+
+		_writer = std::jthread{ [this](std::stop_token stop) { writeFrames(stop); } };
+	}
+
+	Recorder::~Recorder()
+	{
+		finish();
+
+		if (_file == stdout) { std::fflush(_file); }
+		else { std::fclose(_file); }
+	}
+
+	void Recorder::finish()
+	{
+		{
+			std::scoped_lock lock{_queueLock};
+			_finished = true;
+		}
+
+		_writer.request_stop();
+		if (_writer.joinable()) { _writer.join(); }
+	}
+
+	bool Recorder::push(std::span<const uint32_t> pixels)
+	{
+		std::vector<uint32_t> frame;
+
+		{
+			std::scoped_lock lock{_queueLock};
+
+			if (_finished || _failed || _queue.size() >= queueCapacity)
+			{
+				++_dropped;
+				return false;
+			}
+
+			if (!_spare.empty())
+			{
+				frame = std::move(_spare.front());
+				_spare.pop_front();
+			}
+		}
+
+		// Copy outside the lock, so the writer is never held up by it.
+		frame.assign(pixels.begin(), pixels.end());
+
+		{
+			std::scoped_lock lock{_queueLock};
+			_queue.push_back(std::move(frame));
+		}
+
+		_queueCondition.notify_one();
+		return true;
+	}
+
+	void Recorder::writeFrames(std::stop_token stop)
+	{
+		std::unique_lock lock{_queueLock};
+
+		// Once stopped, the frames already queued are still written.
+		while (_queueCondition.wait(lock, stop, [this]() { return !_queue.empty(); }) || !_queue.empty())
+		{
+			auto frame = std::move(_queue.front());
+			_queue.pop_front();
+			lock.unlock();
+
+			encode(frame);
+
+			if (!_failed && std::fwrite(_encoded.data(), 1u, _encoded.size(), _file) == _encoded.size())
+			{
+				++_written;
+			}
+			else
+			{
+				_failed = true;
+			}
+
+			lock.lock();
+			_spare.push_back(std::move(frame));
+		}
+	}
+
+	void Recorder::encode(std::span<const uint32_t> pixels)
+	{
+		const auto count = static_cast<std::size_t>(_width * _height);
+		_encoded.clear();
+
+		if (_format == VideoFormat::Y4M)
+		{
+			constexpr std::string_view frameHeader = "FRAME\n";
+			_encoded.resize(frameHeader.size() + (3u * count));
+			std::ranges::copy(frameHeader, _encoded.begin());
+
+			// Planar: all the luma samples, then both chroma planes at full resolution.
+			auto* y = _encoded.data() + frameHeader.size();
+			auto* u = y + count;
+			auto* v = u + count;
+
+			for (auto i = 0uz; i < count; ++i)
+			{
+				const auto c = unpack(pixels[i]);
+				y[i] = luma(c);
+				u[i] = chromaBlue(c);
+				v[i] = chromaRed(c);
+			}
+		}
+		else
+		{
+			const auto header = fmt::format("P6\n{} {}\n255\n", _width, _height);
+			_encoded.resize(header.size() + (3u * count));
+			std::ranges::copy(header, _encoded.begin());
+
+			auto* rgb = _encoded.data() + header.size();
+
+			for (auto i = 0uz; i < count; ++i)
+			{
+				const auto c = unpack(pixels[i]);
+				rgb[(3u * i) + 0u] = static_cast<uint8_t>(c.r);
+				rgb[(3u * i) + 1u] = static_cast<uint8_t>(c.g);
+				rgb[(3u * i) + 2u] = static_cast<uint8_t>(c.b);
+			}
+		}
+	}
+}
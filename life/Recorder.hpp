@@ -0,0 +1,82 @@
+#ifndef LIFE_RECORDER_HPP
+#define LIFE_RECORDER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace life
+{
+    enum class VideoFormat : uint8_t
+    {
+        Y4M,    // YUV4MPEG2, 4:4:4 planar. Readable by ffmpeg, x264 and most other encoders.
+        PPM     // A stream of binary PPM (P6) images, e.g. for ffmpeg -f image2pipe.
+    };
+
+    /*
+        Streams frames to a file, or to stdout for "-", without compression. The caller only
+        copies each frame into a bounded queue; converting and writing happens on a background
+        thread. When the writer falls behind, frames are dropped rather than holding up the caller.
+    */
+    class Recorder
+    {
+    public:
+        // Frames waiting to be written, beyond which push() drops frames.
+        static constexpr auto queueCapacity = 8uz;
+
+        // Files ending in ".ppm" are written as PPM, anything else as Y4M, declaring the frame rate to a thousandth.
+        // Throws std::runtime_error if the file can't be opened.
+        Recorder(const std::string& path, uint64_t width, uint64_t height, double framesPerSecond);
+
+        // Calls finish(), then closes the file.
+        ~Recorder();
+
+        Recorder(const Recorder&) = delete;
+        Recorder& operator=(const Recorder&) = delete;
+        Recorder(Recorder&&) = delete;
+        Recorder& operator=(Recorder&&) = delete;
+
+        // Queues a copy of one frame of width * height RGBA pixels. Returns false if it was dropped.
+        bool push(std::span<const uint32_t> pixels);
+
+        // Writes every frame still in the queue and stops the writer. Frames pushed afterwards are dropped.
+        void finish();
+
+        [[nodiscard]] uint64_t written() const noexcept { return _written; }
+        [[nodiscard]] uint64_t dropped() const noexcept { return _dropped; }
+        [[nodiscard]] bool failed() const noexcept { return _failed; }
+
+    private:
+        void writeFrames(std::stop_token stop);
+        void encode(std::span<const uint32_t> pixels);
+
+        uint64_t _width;
+        uint64_t _height;
+        VideoFormat _format;
+        std::FILE* _file;
+
+        std::vector<uint8_t> _encoded;
+
+        // Queued frames, and spare buffers to reuse so recording doesn't allocate every frame.
+        std::deque<std::vector<uint32_t>> _queue, _spare;
+        std::mutex _queueLock;
+        std::condition_variable_any _queueCondition;
+        bool _finished = false;
+
+        std::atomic<uint64_t> _written = 0u, _dropped = 0u;
+        std::atomic<bool> _failed = false;
+
+        // Last, so the writer is joined before anything it uses is destroyed.
+        std::jthread _writer;
+    };
+}
+
+#endif
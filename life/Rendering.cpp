@@ -0,0 +1,177 @@
+#include <Rendering.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <utility>
+#include <bit>
+#include <cstring>
+#include <execution>
+
+namespace life
+{
+	template<uint64_t Magnify>
+	static void expandRowFixed(std::span<const CellState> cells, std::span<uint32_t> pixels, uint32_t alive, uint32_t dead) noexcept
+	{
+		// Cells are 0 or 1, so negating one gives an all-zero or all-one mask and the choice of colour needs no branch.
+		const auto flip = alive ^ dead;
+		const auto toPixel = [flip, dead](CellState cell) { return dead ^ (flip & (0u - static_cast<uint32_t>(cell))); };
+
+		// Blocks go through local arrays, which cannot alias, so the compiler vectorizes them without runtime checks.
+		constexpr auto blockCells = 16uz;
+		std::array<CellState, blockCells> in{};
+		std::array<uint32_t, blockCells * Magnify> out{};
+
+		const auto whole = std::min(static_cast<uint64_t>(cells.size()), pixels.size() / Magnify);
+		auto i = 0uz;
+
+		for(; i + blockCells <= whole; i += blockCells)
+		{
+			std::memcpy(in.data(), &cells[i], sizeof(in));
+
+			for(auto c = 0uz; c < blockCells; ++c)
+			{
+				for(auto j = 0uz; j < Magnify; ++j)
+				{
+					out[(c * Magnify) + j] = toPixel(in[c]);
+				}
+			}
+
+			std::memcpy(&pixels[i * Magnify], out.data(), sizeof(out));
+		}
+
+		for(; i < cells.size(); ++i)
+		{
+			const auto first = std::min(i * Magnify, pixels.size());
+			const auto last = std::min(first + Magnify, pixels.size());
+			std::fill(pixels.begin() + static_cast<std::ptrdiff_t>(first), pixels.begin() + static_cast<std::ptrdiff_t>(last), toPixel(cells[i]));
+		}
+	}
+
+	void expandRow(std::span<const CellState> cells, uint64_t magnify, std::span<uint32_t> pixels, uint32_t alive, uint32_t dead) noexcept
+	{
+		using Kernel = void (*)(std::span<const CellState>, std::span<uint32_t>, uint32_t, uint32_t) noexcept;
+
+		static constexpr auto kernels = []<std::size_t... Magnify>(std::index_sequence<Magnify...>)
+		{
+			return std::array<Kernel, sizeof...(Magnify)>{ &expandRowFixed<Magnify + 1u>... };
+		}(std::make_index_sequence<maxMagnify>{});
+
+		kernels[std::clamp(magnify, uint64_t{1}, maxMagnify) - 1u](cells, pixels, alive, dead);
+	}
+
+	void expandRowPalette(std::span<const CellState> cells, std::span<const uint8_t> ages, uint64_t magnify, std::span<uint32_t> pixels, std::span<const uint32_t, 512> palette) noexcept
+	{
+		for(auto i = 0uz; i < cells.size(); ++i)
+		{
+			const auto first = std::min(i * magnify, pixels.size());
+			const auto last = std::min(first + magnify, pixels.size());
+			const auto pixel = palette[(static_cast<std::size_t>(cells[i]) << 8u) | ages[i]];
+
+			std::fill(pixels.begin() + static_cast<std::ptrdiff_t>(first), pixels.begin() + static_cast<std::ptrdiff_t>(last), pixel);
+		}
+	}
+
+	uint64_t countAlive(std::span<const CellState> cells) noexcept
+	{
+		constexpr auto wordSize = sizeof(uint64_t);
+
+		uint64_t total{};
+		auto i = 0uz;
+
+		for(; i + wordSize <= cells.size(); i += wordSize)
+		{
+			uint64_t word{};
+			std::memcpy(&word, &cells[i], wordSize);
+			total += static_cast<uint64_t>(std::popcount(word));
+		}
+
+		for(; i < cells.size(); ++i)
+		{
+			total += (cells[i] == CellState::Alive) ? 1u : 0u;
+		}
+
+		return total;
+	}
+
+	void accumulateDensity(std::span<const CellState> row, uint64_t zoom, std::span<uint32_t> counts) noexcept
+	{
+		for(auto i = 0uz; i < counts.size(); ++i)
+		{
+			const auto first = i * zoom;
+			if(first >= row.size()) { break; }
+
+			counts[i] += static_cast<uint32_t>(countAlive(row.subspan(first, std::min(zoom, row.size() - first))));
+		}
+	}
+
+	bool paintCells(const Generation& generation, uint64_t worldWidth, CellRect view, uint64_t magnify, const CellColours& colours,
+		std::span<const uint64_t> rows, std::span<uint32_t> pixels, uint64_t screenWidth, ShownCells& shown, bool incremental)
+	{
+		const auto screenHeight = pixels.size() / screenWidth;
+		const auto byAge = !colours.palette.empty();
+		const std::span<CellState> shownCells{ shown.cells };
+		rows = rows.first(view.h);
+
+		// Ages change everywhere every generation, so colouring by age is always painted in full.
+		if(incremental && shown.valid && !shown.byAge && !byAge)
+		{
+			// Only cells that flipped since the last frame are written, so the cost follows churn, not population.
+			std::atomic<uint64_t> flips{};
+
+			std::for_each(std::execution::par, rows.begin(), rows.end(),
+			[&generation, &view, &colours, &flips, pixels, shownCells, worldWidth, magnify, screenWidth, screenHeight](uint64_t cellY)
+			{
+				const auto row = std::span<const CellState>{ generation.cells }.subspan(((view.y + cellY) * worldWidth) + view.x, view.w);
+				const auto firstLine = cellY * magnify;
+				const auto lastLine = std::min(firstLine + magnify, screenHeight);
+
+				flips += applyFlips(row, shownCells.subspan(cellY * screenWidth, view.w),
+				[=, &colours](std::size_t x, CellState state)
+				{
+					const auto firstColumn = x * magnify;
+					const auto lastColumn = std::min(firstColumn + magnify, screenWidth);
+					const auto colour = (state == CellState::Alive) ? colours.alive : colours.dead;
+
+					for(auto line = firstLine; line < lastLine; ++line)
+					{
+						std::ranges::fill(pixels.subspan((line * screenWidth) + firstColumn, lastColumn - firstColumn), colour);
+					}
+				});
+			});
+
+			return flips > 0u;
+		}
+
+		std::ranges::fill(pixels, colours.dead);
+
+		std::for_each(std::execution::par, rows.begin(), rows.end(),
+		[&generation, &view, &colours, pixels, shownCells, worldWidth, magnify, screenWidth, screenHeight, byAge](uint64_t cellY)
+		{
+			const auto row = std::span<const CellState>{ generation.cells }.subspan(((view.y + cellY) * worldWidth) + view.x, view.w);
+			const auto firstLine = cellY * magnify;
+			const auto lastLine = std::min(firstLine + magnify, screenHeight);
+			const auto line = pixels.subspan(firstLine * screenWidth, screenWidth);
+
+			// Expand the row once, then repeat the finished line for the rest of the cell's height.
+			if(byAge)
+			{
+				const auto ages = std::span<const uint8_t>{ generation.ages }.subspan(((view.y + cellY) * worldWidth) + view.x, view.w);
+				expandRowPalette(row, ages, magnify, line, colours.palette.first<512>());
+			}
+			else
+			{
+				expandRow(row, magnify, line, colours.alive, colours.dead);
+			}
+			for(auto copy = firstLine + 1u; copy < lastLine; ++copy)
+			{
+				std::ranges::copy(line, pixels.subspan(copy * screenWidth).begin());
+			}
+
+			std::ranges::copy(row, shownCells.subspan(cellY * screenWidth).begin());
+		});
+
+		shown.valid = true;
+		shown.byAge = byAge;
+		return true;
+	}
+}
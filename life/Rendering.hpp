@@ -0,0 +1,110 @@
+#ifndef LIFE_RENDERING_HPP
+#define LIFE_RENDERING_HPP
+
+#include <Camera.hpp>
+#include <Cell.hpp>
+#include <Generation.hpp>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace life
+{
+    // Largest number of screen pixels a cell can be magnified to, along each axis.
+    constexpr uint64_t maxMagnify = 16u;
+
+    /*
+        Turns a row of cells into packed 32-bit pixels, repeating each cell magnify times
+        (1 to maxMagnify). Output stops at the end of pixels, so a partly visible cell at the
+        edge is clipped. Every magnification has its own kernel with a fixed repeat count,
+        which the compiler turns into straight vector stores.
+    */
+    void expandRow(std::span<const CellState> cells, uint64_t magnify, std::span<uint32_t> pixels, uint32_t alive, uint32_t dead) noexcept;
+
+    // Like expandRow, but each cell is coloured by its state and age: palette[age] for dead cells, palette[256 + age] for live ones.
+    void expandRowPalette(std::span<const CellState> cells, std::span<const uint8_t> ages, uint64_t magnify, std::span<uint32_t> pixels, std::span<const uint32_t, 512> palette) noexcept;
+
+    // How paintCells() colours cells: alive and dead, or by age from a palette laid out as expandRowPalette() expects.
+    struct CellColours
+    {
+        uint32_t alive{};
+        uint32_t dead{};
+        std::span<const uint32_t> palette;
+    };
+
+    /*
+        The cells the last frame painted, one per screen pixel row by row, so the next frame can
+        repaint only the cells that flipped. That only works if both are coloured the same way:
+        a frame painted by age is stale everywhere once the colouring changes.
+    */
+    struct ShownCells
+    {
+        std::vector<CellState> cells;
+        bool valid = false;
+        bool byAge = false;
+    };
+
+    /*
+        Paints the view of the world into pixels, screenWidth wide, each cell a magnify x magnify
+        block, and everything else in the dead colour. With incremental set, and shown painted
+        in plain colours, only the cells that flipped since are repainted. rows holds 0, 1, 2,
+        ... for at least view.h entries, to run the rows in parallel. Returns false if no pixel
+        changed.
+    */
+    bool paintCells(const Generation& generation, uint64_t worldWidth, CellRect view, uint64_t magnify, const CellColours& colours,
+        std::span<const uint64_t> rows, std::span<uint32_t> pixels, uint64_t screenWidth, ShownCells& shown, bool incremental);
+
+    // Number of live cells in a run. Cells are bytes holding 0 or 1, so the population
+    // of eight neighbouring cells is the popcount of the 64-bit word they form.
+    [[nodiscard]] uint64_t countAlive(std::span<const CellState> cells) noexcept;
+
+    // Adds the population of each consecutive zoom-wide block of row to the matching entry of counts.
+    void accumulateDensity(std::span<const CellState> row, uint64_t zoom, std::span<uint32_t> counts) noexcept;
+
+    // Calls onFlip(x) for every cell that differs between the two runs, which are the same length.
+    // Unchanged runs are skipped eight cells at a time by XORing whole words. Returns the number of flips.
+    template<typename OnFlip>
+    uint64_t forEachFlip(std::span<const CellState> previous, std::span<const CellState> current, OnFlip&& onFlip)
+    {
+        constexpr auto wordSize = sizeof(uint64_t);
+
+        uint64_t flips{};
+        const auto visit = [&](std::size_t x)
+        {
+            if (current[x] == previous[x]) { return; }
+
+            onFlip(x);
+            ++flips;
+        };
+
+        auto x = 0uz;
+        for (; x + wordSize <= current.size(); x += wordSize)
+        {
+            uint64_t now{}, before{};
+            std::memcpy(&now, &current[x], wordSize);
+            std::memcpy(&before, &previous[x], wordSize);
+
+            if ((now ^ before) == 0u) { continue; }
+
+            for (auto i = x; i < x + wordSize; ++i) { visit(i); }
+        }
+
+        for (; x < current.size(); ++x) { visit(x); }
+
+        return flips;
+    }
+
+    // Brings shown up to date with row and calls onFlip(x, state) for every cell that changed. Returns the number of flips.
+    template<typename OnFlip>
+    uint64_t applyFlips(std::span<const CellState> row, std::span<CellState> shown, OnFlip&& onFlip)
+    {
+        return forEachFlip(shown, row, [&](std::size_t x)
+        {
+            shown[x] = row[x];
+            onFlip(x, row[x]);
+        });
+    }
+}
+
+#endif
\ No newline at end of file
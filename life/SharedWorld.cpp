@@ -0,0 +1,227 @@
+#include <SharedWorld.hpp>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <fmt/format.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LIFE_HAS_SHARED_MEMORY 1
+#endif
+
+namespace life
+{
+	namespace
+	{
+		// POSIX wants shared-memory names to start with a slash.
+		std::string segmentName(std::string name)
+		{
+			return name.starts_with('/') ? name : "/" + name;
+		}
+
+#if defined(LIFE_HAS_SHARED_MEMORY)
+		std::size_t segmentSize(uint64_t width, uint64_t height)
+		{
+			return SharedWorldHeader::cellsOffset + (3u * width * height);
+		}
+
+		// Fails with EEXIST if there already is a segment of that name.
+		int createSegment(const std::string& name)
+		{
+			return shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+		}
+
+		// True if the segment is a shared world whose writer has exited without removing it, e.g. after a crash.
+		bool isStale(const std::string& name)
+		{
+			const int descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+			if (descriptor < 0) { return false; }
+
+			struct stat status{};
+			void* memory = (fstat(descriptor, &status) == 0 && static_cast<std::size_t>(status.st_size) >= SharedWorldHeader::cellsOffset)
+				? mmap(nullptr, SharedWorldHeader::cellsOffset, PROT_READ, MAP_SHARED, descriptor, 0)
+				: MAP_FAILED;
+			close(descriptor);
+
+			if (memory == MAP_FAILED) { return false; }
+
+			const auto* header = static_cast<const SharedWorldHeader*>(memory);
+			const bool stale = header->magic == SharedWorldHeader::expectedMagic && header->owner > 0u
+				&& kill(static_cast<pid_t>(header->owner), 0) != 0 && errno == ESRCH;
+
+			munmap(memory, SharedWorldHeader::cellsOffset);
+			return stale;
+		}
+
+		const CellState* slotCells(const SharedWorldHeader* header, uint64_t slot)
+		{
+			return reinterpret_cast<const CellState*>(reinterpret_cast<const std::byte*>(header) + SharedWorldHeader::cellsOffset + (slot * header->width * header->height));
+		}
+#endif
+	}
+
+#if defined(LIFE_HAS_SHARED_MEMORY)
+	SharedWorld::SharedWorld(std::string name, uint64_t width, uint64_t height)
+		: _name(segmentName(std::move(name))), _bytes(segmentSize(width, height))
+	{
+		// Another game may be sharing under this name; taking its segment over would mix both worlds.
+		int descriptor = createSegment(_name);
+		bool inUse = descriptor < 0 && errno == EEXIST;
+
+		if (inUse && isStale(_name))
+		{
+			shm_unlink(_name.c_str());
+			descriptor = createSegment(_name);
+			inUse = descriptor < 0 && errno == EEXIST;
+		}
+
+		if (inUse)
+		{
+			throw std::runtime_error{ fmt::format("Shared memory '{}' is already in use by another process", _name) };
+		}
+
+		if (descriptor < 0)
+		{
+			throw std::runtime_error{ fmt::format("Can't create shared memory '{}' (errno {})", _name, errno) };
+		}
+
+		void* memory = (ftruncate(descriptor, static_cast<off_t>(_bytes)) == 0)
+			? mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0)
+			: MAP_FAILED;
+		close(descriptor);
+
+		if (memory == MAP_FAILED)
+		{
+			shm_unlink(_name.c_str());
+			throw std::runtime_error{ fmt::format("Can't map shared memory '{}' (errno {})", _name, errno) };
+		}
+
+		// Nothing is published until the first generation is complete, so every slot starts out being written.
+		_header = new (memory) SharedWorldHeader{ .magic={}, .width=width, .height=height,
+			.owner=static_cast<uint64_t>(getpid()), .latest={}, .slots={} };
+		for (auto& slot : _header->slots) { slot.sequence.store(1u, std::memory_order_relaxed); }
+
+		_cells = std::span<CellState>{ reinterpret_cast<CellState*>(static_cast<std::byte*>(memory) + SharedWorldHeader::cellsOffset), 3u * width * height };
+
+		// Readers check the magic, so it is written last.
+		std::atomic_thread_fence(std::memory_order_release);
+		_header->magic = SharedWorldHeader::expectedMagic;
+	}
+
+	SharedWorld::~SharedWorld()
+	{
+		// Readers that still have it mapped keep their mapping; the name is free again right away.
+		munmap(_header, _bytes);
+		shm_unlink(_name.c_str());
+	}
+
+	std::size_t SharedWorld::slotOf(const Generation& generation) const noexcept
+	{
+		return static_cast<std::size_t>(generation.cells.data() - _cells.data()) / (_cells.size() / 3u);
+	}
+
+	void SharedWorld::publish(const Generation& published, const Generation& next) noexcept
+	{
+		// The workers finished writing the published slot before the barrier let the completion run.
+		const auto slot = slotOf(published);
+		auto& done = _header->slots[slot];
+
+		done.number.store(published.number, std::memory_order_relaxed);
+		done.sequence.store((done.sequence.load(std::memory_order_relaxed) | 1u) + 1u, std::memory_order_release);
+		_header->latest.store(slot, std::memory_order_release);
+
+		// The workers only start on the next slot once the completion returns.
+		auto& writing = _header->slots[slotOf(next)];
+		const auto sequence = writing.sequence.load(std::memory_order_relaxed);
+
+		if (sequence % 2u == 0u)
+		{
+			writing.sequence.store(sequence + 1u, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+
+		++_published;
+	}
+
+	SharedWorldView::SharedWorldView(std::string name)
+	{
+		const auto segment = segmentName(std::move(name));
+		const int descriptor = shm_open(segment.c_str(), O_RDONLY, 0);
+		if (descriptor < 0)
+		{
+			throw std::runtime_error{ fmt::format("No shared world '{}' (errno {})", segment, errno) };
+		}
+
+		struct stat status{};
+		void* memory = (fstat(descriptor, &status) == 0 && static_cast<std::size_t>(status.st_size) >= SharedWorldHeader::cellsOffset)
+			? mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0)
+			: MAP_FAILED;
+		close(descriptor);
+
+		if (memory == MAP_FAILED)
+		{
+			throw std::runtime_error{ fmt::format("Can't map shared world '{}'", segment) };
+		}
+
+		_bytes = static_cast<std::size_t>(status.st_size);
+		_header = static_cast<const SharedWorldHeader*>(memory);
+
+		if (_header->magic != SharedWorldHeader::expectedMagic || _bytes < segmentSize(_header->width, _header->height))
+		{
+			munmap(memory, _bytes);
+			throw std::runtime_error{ fmt::format("'{}' is not a shared world", segment) };
+		}
+	}
+
+	SharedWorldView::~SharedWorldView()
+	{
+		munmap(const_cast<SharedWorldHeader*>(_header), _bytes);
+	}
+
+	bool SharedWorldView::snapshot(std::span<CellState> cells, uint64_t& number) const noexcept
+	{
+		constexpr auto attempts = 16u;
+
+		for (auto attempt = 0u; attempt < attempts; ++attempt)
+		{
+			const auto slot = _header->latest.load(std::memory_order_acquire);
+			const auto& guard = _header->slots[slot];
+
+			const auto before = guard.sequence.load(std::memory_order_acquire);
+			if (before % 2u != 0u) { continue; }
+
+			std::memcpy(cells.data(), slotCells(_header, slot), cells.size());
+			number = guard.number.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (guard.sequence.load(std::memory_order_relaxed) == before) { return true; }
+		}
+
+		return false;
+	}
+#else
+	SharedWorld::SharedWorld(std::string name, uint64_t /*width*/, uint64_t /*height*/)
+		: _name(segmentName(std::move(name))), _bytes{}
+	{
+		throw std::runtime_error{ "Shared memory export is not supported on this platform" };
+	}
+
+	SharedWorld::~SharedWorld() = default;
+	std::size_t SharedWorld::slotOf(const Generation& /*generation*/) const noexcept { return 0u; }
+	void SharedWorld::publish(const Generation& /*published*/, const Generation& /*next*/) noexcept {}
+
+	SharedWorldView::SharedWorldView(std::string /*name*/) : _bytes{}
+	{
+		throw std::runtime_error{ "Shared memory export is not supported on this platform" };
+	}
+
+	SharedWorldView::~SharedWorldView() = default;
+	bool SharedWorldView::snapshot(std::span<CellState> /*cells*/, uint64_t& /*number*/) const noexcept { return false; }
+#endif
+}
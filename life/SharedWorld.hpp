@@ -0,0 +1,123 @@
+#ifndef LIFE_SHAREDWORLD_HPP
+#define LIFE_SHAREDWORLD_HPP
+
+#include <Cell.hpp>
+#include <Generation.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace life
+{
+    /*
+        The layout of the shared-memory segment, for readers in other processes and languages.
+        Three slots of width * height cells, one byte per cell (0 dead, 1 alive), follow the
+        header. They are the simulation's own generations in flight: the workers compute each
+        generation straight into a slot, and publishing it only updates the header. Each slot
+        is guarded by a sequence number that is odd while the workers write it. A reader
+        copies the slot named by `latest`, then checks that its sequence number was even and
+        unchanged throughout; otherwise it retries. A published slot is written again at the
+        earliest one generation later, so a retry is only needed if the reader is slower.
+    */
+    struct SharedWorldHeader
+    {
+        static constexpr std::array<char, 8> expectedMagic{ 'L', 'I', 'F', 'E', 'S', 'H', 'M', '3' };
+
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence;
+            std::atomic<uint64_t> number;
+        };
+
+        std::array<char, 8> magic;
+        uint64_t width;
+        uint64_t height;
+
+        // Process id of the writer, so a segment left behind by a crash can be told from one in use.
+        uint64_t owner;
+
+        std::atomic<uint64_t> latest;
+        std::array<Slot, 3> slots;
+
+        // The cells of slot i start at cellsOffset + i * width * height, a page in, so they
+        // don't share a page with the header.
+        static constexpr std::size_t cellsOffset = 4096u;
+    };
+
+    static_assert(sizeof(SharedWorldHeader) <= SharedWorldHeader::cellsOffset);
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The sequence numbers are shared between processes");
+
+    /*
+        A POSIX shared-memory segment, e.g. "/life", that holds the simulation's generations
+        for other processes to map read-only. Readers never wait for, or slow down, the
+        writer. The segment is removed again when this is destroyed, so it must outlive the
+        simulation computing into it. A segment of the same name is only replaced if the process
+        that wrote it is gone. Throws std::runtime_error if the name is in use or the segment
+        can't be created.
+    */
+    class SharedWorld
+    {
+    public:
+        SharedWorld(std::string name, uint64_t width, uint64_t height);
+        ~SharedWorld();
+
+        SharedWorld(const SharedWorld&) = delete;
+        SharedWorld& operator=(const SharedWorld&) = delete;
+        SharedWorld(SharedWorld&&) = delete;
+        SharedWorld& operator=(SharedWorld&&) = delete;
+
+        // The cells of the three slots, one after the other, for SimulationSettings::frameCells.
+        [[nodiscard]] std::span<CellState> cells() const noexcept { return _cells; }
+
+        /*
+            Names published, which must be one of the slots, as the newest generation, and marks
+            next, which the workers are about to compute, as being written. Neither copies any
+            cells, so this can run in the completion hook. Only one thread may publish.
+        */
+        void publish(const Generation& published, const Generation& next) noexcept;
+
+        [[nodiscard]] const std::string& name() const noexcept { return _name; }
+        [[nodiscard]] uint64_t published() const noexcept { return _published; }
+
+    private:
+        std::size_t slotOf(const Generation& generation) const noexcept;
+
+        std::string _name;
+        std::size_t _bytes;
+        SharedWorldHeader* _header = nullptr;
+        std::span<CellState> _cells;
+        uint64_t _published{};
+    };
+
+    /*
+        The reading side, mapping a segment published by another process read-only. Throws
+        std::runtime_error if there is no such segment or it isn't a published world.
+    */
+    class SharedWorldView
+    {
+    public:
+        explicit SharedWorldView(std::string name);
+        ~SharedWorldView();
+
+        SharedWorldView(const SharedWorldView&) = delete;
+        SharedWorldView& operator=(const SharedWorldView&) = delete;
+        SharedWorldView(SharedWorldView&&) = delete;
+        SharedWorldView& operator=(SharedWorldView&&) = delete;
+
+        [[nodiscard]] uint64_t width() const noexcept { return _header->width; }
+        [[nodiscard]] uint64_t height() const noexcept { return _header->height; }
+
+        // Copies a consistent generation into cells, which must hold width * height cells, and
+        // returns its number. Returns false if the writer kept overtaking the copy.
+        bool snapshot(std::span<CellState> cells, uint64_t& number) const noexcept;
+
+    private:
+        std::size_t _bytes;
+        const SharedWorldHeader* _header = nullptr;
+    };
+}
+
+#endif
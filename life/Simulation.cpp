@@ -0,0 +1,526 @@
+#include <Simulation.hpp>
+#include <Placement.hpp>
+#include <Rendering.hpp>
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <fmt/format.h>
+
+namespace life
+{
+	Simulation::Simulation(uint64_t width, uint64_t height, std::size_t numThreads, const SimulationSettings& settings)
+		: _width(width), _height(height), _numThreads(numThreads), _tracksAges(settings.trackAges), _profileLoad(settings.profileLoad), _countEvents(settings.countEvents), _rebalanceEvery(settings.rebalanceEvery),
+		_kernel(settings.kernel), _tileWidth((settings.tileWidth > 0u) ? std::min(settings.tileWidth, maxTileWidth) : autoTileWidth()),
+		_generationsPerPass((settings.kernel == Kernel::Tiled && !settings.trackAges) ? std::clamp(settings.generationsPerPass, uint64_t{1}, maxGenerationsPerPass) : 1u),
+		_temporalTile(autoTemporalTile(_generationsPerPass)),
+		_barrier(static_cast<std::ptrdiff_t>(numThreads), Completion{ this }), _placement(numThreads), _workerTimes(numThreads), _perfCounts(numThreads), _bands(numThreads)
+	{
+		_profile.populationSum.resize(numThreads);
+
+		const auto cellCount = width * height;
+		if(!settings.frameCells.empty() && settings.frameCells.size() != 3uz * cellCount)
+		{
+			throw std::runtime_error{ fmt::format("Need {} cells for the generations in flight, got {}", 3uz * cellCount, settings.frameCells.size()) };
+		}
+
+		// Left untouched here, the workers place them.
+		for(auto i = 0uz; auto& slot : _frames.slots())
+		{
+			if(!settings.frameCells.empty())
+			{
+				slot.cells = CellBuffer{ WorldAllocator<CellState>{ settings.frameCells.subspan(i * cellCount, cellCount) } };
+			}
+
+			slot.cells.resize(cellCount);
+			slot.ages.resize(_tracksAges ? cellCount : 0u);
+			++i;
+		}
+
+		// Consecutive bands go to consecutive CPUs of the same node, so only the bands
+		// at the edges of a node read rows from another node.
+		const auto cpus = settings.pinThreads ? usableCpus() : std::vector<int>{};
+		const auto rowsPerThread = _height / _numThreads;
+
+		std::latch placed{ static_cast<std::ptrdiff_t>(numThreads) };
+
+		for(auto i = 0uz; i < _numThreads; ++i)
+		{
+			const auto firstRow = rowsPerThread * i;
+			const auto lastRow = (i + 1uz == _numThreads) ? _height : firstRow + rowsPerThread;
+			const auto cpu = cpus.empty() ? -1 : cpus[(i * cpus.size()) / _numThreads];
+
+			_bands[i] = Band{ .firstRow=firstRow, .lastRow=lastRow };
+			_threadPool.emplace_back([this, i, cpu, &placed](std::stop_token stop)
+			{
+				work(stop, i, cpu, placed);
+			});
+		}
+
+		placed.wait();
+	}
+
+	Simulation::~Simulation()
+	{
+		stop();
+	}
+
+	void Simulation::seed(const CounterRng& random, double density)
+	{
+		// Every cell draws from its own counter, so the chunks can be filled in any order
+		// and the world is the same no matter how many threads took part.
+		constexpr auto cellsPerChunk = 1uz << 16u;
+
+		auto& cells = _frames.back().cells;
+
+		std::vector<uint64_t> chunks((cells.size() + cellsPerChunk - 1uz) / cellsPerChunk);
+		std::iota(chunks.begin(), chunks.end(), uint64_t{});
+
+		std::for_each(std::execution::par, chunks.cbegin(), chunks.cend(),
+		[&cells, random, density](uint64_t chunk)
+		{
+			const auto first = chunk * cellsPerChunk;
+			const auto last = std::min(first + cellsPerChunk, static_cast<uint64_t>(cells.size()));
+
+			for(auto i = first; i < last; ++i)
+			{
+				cells[i] = random.chance(i, density) ? CellState::Alive : CellState::Dead;
+			}
+		});
+
+		_frames.back().number = 0u;
+		_frames.publish();
+	}
+
+	void Simulation::restore(const Generation& generation)
+	{
+		auto& back = _frames.back();
+
+		back.cells = generation.cells;
+		back.number = generation.number;
+
+		// A checkpoint taken without ages starts every cell's age from zero.
+		if(_tracksAges && generation.ages.size() == back.ages.size())
+		{
+			back.ages = generation.ages;
+		}
+
+		_frames.publish();
+	}
+
+	void Simulation::start()
+	{
+		{
+			std::scoped_lock lock{_pauseLock};
+			_started = true;
+		}
+
+		_resumeCondition.notify_all();
+	}
+
+	void Simulation::work(std::stop_token stop, std::size_t index, int cpu, std::latch& placed)
+	{
+		placeBand(index, _bands[index].firstRow, _bands[index].lastRow, cpu);
+		placed.count_down();
+
+		{
+			std::unique_lock lock{_pauseLock};
+			_resumeCondition.wait(lock, stop, [this](){ return _started; });
+		}
+
+		if(_tracer != nullptr) { _tracer->attach(fmt::format("Worker {}", index)); }
+
+		auto& times = _workerTimes[index];
+
+		// Only this worker writes its entry, so a plain load and store is enough.
+		const auto add = [](std::atomic<int64_t>& total, std::chrono::steady_clock::duration time)
+		{
+			total.store(total.load(std::memory_order_relaxed) + std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(), std::memory_order_relaxed);
+		};
+
+		// Opened by the worker itself, since the events are counted per thread.
+		std::optional<PerfCounters> events;
+		if(_countEvents) { events.emplace(); }
+		uint64_t cellsStepped = 0u;
+
+		// Allocated once, and first touched here, rather than for every pass.
+		auto scratch = (_generationsPerPass > 1u) ? TemporalScratch{ _width, _height, _generationsPerPass, _temporalTile } : TemporalScratch{};
+
+		while(!stop.stop_requested())
+		{
+			// Only ever changed by the completion, while every worker waits at the barrier.
+			const auto [firstRow, lastRow] = _bands[index];
+			const auto started = std::chrono::steady_clock::now();
+
+			if(events) { events->resume(); }
+			step(firstRow, lastRow, scratch);
+			if(events) { events->pause(); }
+			cellsStepped += _generationsPerPass * (lastRow - firstRow) * _width;
+
+			if(_capturing) { captureRows(firstRow, lastRow); }
+			if(_bandHook) { _bandHook(index, firstRow, lastRow, _frames.published(), _frames.back()); }
+
+			const auto computed = std::chrono::steady_clock::now();
+
+			times.lastCompute = std::chrono::duration_cast<std::chrono::nanoseconds>(computed - started).count();
+			times.sinceRebalance += times.lastCompute;
+
+			// Counting is left out of both times, it is only there to explain them.
+			if(_profileLoad)
+			{
+				const auto& cells = _frames.back().cells;
+				times.population = countAlive(std::span{ cells }.subspan(firstRow * _width, (lastRow - firstRow) * _width));
+			}
+
+			const auto arrived = _profileLoad ? std::chrono::steady_clock::now() : computed;
+			_barrier.arrive_and_wait();
+			const auto released = std::chrono::steady_clock::now();
+
+			add(times.compute, computed - started);
+			add(times.barrierWait, released - arrived);
+			trace(TracePhase::Compute, started, computed);
+			trace(TracePhase::BarrierWait, arrived, released);
+
+			if(_paused)
+			{
+				std::unique_lock lock{_pauseLock};
+				_resumeCondition.wait(lock, stop, [this](){ return !_paused; });
+			}
+		}
+
+		// Leaving the barrier lets the remaining workers finish their last generation.
+		_barrier.arrive_and_drop();
+		Tracer::detach();
+
+		if(events)
+		{
+			_perfCounts[index] = events->read();
+			_perfCounts[index].cells = cellsStepped;
+		}
+	}
+
+	void Simulation::placeBand(std::size_t index, uint64_t firstRow, uint64_t lastRow, int cpu)
+	{
+		auto& placement = _placement[index];
+		placement.firstRow = firstRow;
+		placement.lastRow = lastRow;
+		placement.pinned = pinCurrentThread(cpu);
+		placement.cpu = currentCpu();
+		placement.cpuNode = nodeOfCpu(placement.cpu);
+
+		// Writing the band first is what places its pages, zeroing it is incidental.
+		const auto first = static_cast<std::ptrdiff_t>(firstRow * _width);
+		const auto last = static_cast<std::ptrdiff_t>(lastRow * _width);
+
+		for(auto& slot : _frames.slots())
+		{
+			std::fill(slot.cells.begin() + first, slot.cells.begin() + last, CellState::Dead);
+			std::fill(slot.ages.begin() + std::min(first, std::ssize(slot.ages)), slot.ages.begin() + std::min(last, std::ssize(slot.ages)), uint8_t{});
+		}
+
+		if(last > first)
+		{
+			placement.memoryNode = nodeOfAddress(&_frames.slots()[0].cells[static_cast<std::size_t>(first)]);
+		}
+	}
+
+	void Simulation::stop()
+	{
+		_stopping = true;
+
+		for(auto& thread : _threadPool)
+		{
+			thread.request_stop();
+		}
+
+		// Joins every worker.
+		_threadPool.clear();
+	}
+
+	void Simulation::setPaused(bool paused)
+	{
+		{
+			std::scoped_lock lock{_pauseLock};
+			_paused = paused;
+		}
+
+		_resumeCondition.notify_all();
+	}
+
+	void Simulation::step(uint64_t firstRow, uint64_t lastRow, TemporalScratch& scratch)
+	{
+		const auto& from = _frames.published();
+		auto& to = _frames.back();
+
+		if(_generationsPerPass > 1u)
+		{
+			stepTemporal(from, to, _width, _height, firstRow, lastRow, _generationsPerPass, _temporalTile, scratch);
+		}
+		else if(_kernel == Kernel::Tiled)
+		{
+			if(_tracksAges) { stepTiled<true>(from, to, _width, _height, firstRow, lastRow, _tileWidth); }
+			else { stepTiled<false>(from, to, _width, _height, firstRow, lastRow, _tileWidth); }
+		}
+		else
+		{
+			if(_tracksAges) { stepRows<true>(firstRow, lastRow); }
+			else { stepRows<false>(firstRow, lastRow); }
+		}
+	}
+
+	template<bool TrackAges>
+	void Simulation::stepRows(uint64_t firstRow, uint64_t lastRow)
+	{
+		const auto& from = _frames.published();
+		auto& to = _frames.back();
+
+		const std::span<const CellState> source = from.cells;
+		auto& target = to.cells;
+
+		for(auto y = firstRow; y < lastRow; ++y)
+		{
+			for(auto x = 0uz; x < _width; ++x)
+			{
+				const auto neighbors = countNeighbors(source, x, y);
+				const auto index = (y * _width) + x;
+
+				if (source[index] == CellState::Alive)
+				{
+					target[index] = (neighbors == 2 || neighbors == 3) ? CellState::Alive : CellState::Dead;
+				}
+				else
+				{
+					target[index] = (neighbors == 3) ? CellState::Alive : CellState::Dead;
+				}
+
+				// The age is updated while the cell is still in registers, rather than in a second pass over the world.
+				if constexpr (TrackAges)
+				{
+					const auto age = std::min(from.ages[index], uint8_t{254}) + 1u;
+					to.ages[index] = (target[index] == source[index]) ? static_cast<uint8_t>(age) : uint8_t{};
+				}
+			}
+		}
+	}
+
+	void Simulation::captureRows(uint64_t firstRow, uint64_t lastRow)
+	{
+		// The generation being read from stays untouched until the barrier, and the rows were just read anyway.
+		const auto& source = _frames.published();
+		const auto first = static_cast<std::ptrdiff_t>(firstRow * _width);
+		const auto last = static_cast<std::ptrdiff_t>(lastRow * _width);
+
+		std::copy(source.cells.begin() + first, source.cells.begin() + last, _snapshot.cells.begin() + first);
+
+		if(_tracksAges)
+		{
+			std::copy(source.ages.begin() + first, source.ages.begin() + last, _snapshot.ages.begin() + first);
+		}
+	}
+
+	void Simulation::completeGeneration() noexcept
+	{
+		// Once stopping, a worker may have left without computing its rows, so this generation is incomplete.
+		if(_stopping) { return; }
+
+		const TraceScope span{ TracePhase::Completion };
+
+		if(_profileLoad) { profileGeneration(); }
+
+		if(_rebalanceEvery > 0u && ++_passesSinceRebalance >= _rebalanceEvery)
+		{
+			_passesSinceRebalance = 0u;
+			rebalance();
+		}
+
+		if(_capturing)
+		{
+			_capturing = false;
+
+			if(_snapshotHook)
+			{
+				_snapshotHook(_snapshot);
+			}
+		}
+
+		_frames.back().number = _frames.published().number + _generationsPerPass;
+		{
+			const TraceScope publishing{ TracePhase::Publish };
+			_frames.publish();
+		}
+		_generationsCompleted.fetch_add(_generationsPerPass, std::memory_order_relaxed);
+
+		if(_completionHook)
+		{
+			_completionHook(_frames.published());
+		}
+
+		// The snapshot hook may have swapped the buffer for one of a different size.
+		if(_snapshotRequested.exchange(false))
+		{
+			_snapshot.cells.resize(_width * _height);
+			_snapshot.ages.resize(_tracksAges ? _width * _height : 0u);
+			_snapshot.number = _frames.published().number;
+			_capturing = true;
+		}
+
+		// Every worker is parked at the barrier, so this holds the whole simulation back.
+		_governor.pace();
+	}
+
+	void Simulation::profileGeneration() noexcept
+	{
+		int64_t slowest = 0, total = 0;
+
+		for(auto i = 0uz; i < _numThreads; ++i)
+		{
+			const auto& times = _workerTimes[i];
+			slowest = std::max(slowest, times.lastCompute);
+			total += times.lastCompute;
+			_profile.populationSum[i] += static_cast<double>(times.population);
+		}
+
+		++_profile.generations;
+		if(total <= 0) { return; }
+
+		const auto imbalance = static_cast<double>(slowest) * static_cast<double>(_numThreads) / static_cast<double>(total);
+		_profile.imbalanceSum += imbalance;
+		_profile.worstImbalance = std::max(_profile.worstImbalance, imbalance);
+		_imbalance.store(imbalance, std::memory_order_relaxed);
+	}
+
+	void Simulation::rebalance() noexcept
+	{
+		// Every band needs at least one row.
+		if(_height < _numThreads) { return; }
+
+		// Each band's cost is taken to be spread evenly over its rows, so the cost up to any
+		// row is known, and the new boundaries go where it reaches each worker's fair share.
+		std::vector<double> costs(_numThreads);
+
+		for(auto i = 0uz; i < _numThreads; ++i)
+		{
+			auto& times = _workerTimes[i];
+			costs[i] = static_cast<double>(std::max(times.sinceRebalance, int64_t{1}));
+			times.sinceRebalance = 0;
+		}
+
+		std::vector<uint64_t> boundaries(_numThreads + 1uz);
+		boundaries[_numThreads] = _height;
+
+		// Rows only move between workers pinned to the same node, where their pages are: a boundary
+		// between bands on different nodes stays put, and the bands on either side balance on their own.
+		const auto staysPut = [this](std::size_t i)
+		{
+			const auto& above = _placement[i - 1uz];
+			const auto& below = _placement[i];
+			return above.pinned && below.pinned && above.memoryNode >= 0 && below.memoryNode >= 0 && above.memoryNode != below.memoryNode;
+		};
+
+		for(auto first = 0uz; first < _numThreads; )
+		{
+			auto last = first + 1uz;
+			while(last < _numThreads && !staysPut(last)) { ++last; }
+
+			boundaries[first] = _bands[first].firstRow;
+			const auto end = (last < _numThreads) ? _bands[last].firstRow : _height;
+			const auto groupTotal = std::accumulate(costs.begin() + static_cast<std::ptrdiff_t>(first), costs.begin() + static_cast<std::ptrdiff_t>(last), 0.0);
+
+			auto band = first;
+			double before = 0.0;
+
+			for(auto i = first + 1uz; i < last; ++i)
+			{
+				const auto share = groupTotal * static_cast<double>(i - first) / static_cast<double>(last - first);
+				while(band + 1uz < last && before + costs[band] < share)
+				{
+					before += costs[band];
+					++band;
+				}
+
+				const auto rows = static_cast<double>(_bands[band].lastRow - _bands[band].firstRow);
+				const auto target = static_cast<double>(_bands[band].firstRow) + (rows * (share - before) / costs[band]);
+
+				// Moving halfway there keeps a noisy measurement from throwing the bands back and forth.
+				const auto current = static_cast<double>(_bands[i].firstRow);
+				const auto moved = static_cast<uint64_t>(std::llround(current + ((target - current) / 2.0)));
+
+				boundaries[i] = std::clamp(moved, boundaries[i - 1uz] + 1u, end - (last - i));
+			}
+
+			first = last;
+		}
+
+		for(auto i = 0uz; i < _numThreads; ++i)
+		{
+			_bands[i] = Band{ .firstRow=boundaries[i], .lastRow=boundaries[i + 1uz] };
+		}
+	}
+
+	LoadReport Simulation::loadReport() const
+	{
+		LoadReport report{ .workers={}, .generations=_profile.generations,
+			.meanImbalance=(_profile.generations > 0u) ? _profile.imbalanceSum / static_cast<double>(_profile.generations) : 0.0,
+			.worstImbalance=_profile.worstImbalance, .runImbalance=0.0 };
+
+		std::chrono::nanoseconds slowest{}, total{};
+
+		for(auto i = 0uz; i < _numThreads; ++i)
+		{
+			const auto compute = std::chrono::nanoseconds{ _workerTimes[i].compute.load(std::memory_order_relaxed) };
+			slowest = std::max(slowest, compute);
+			total += compute;
+
+			report.workers.push_back(WorkerLoad{ .firstRow=_bands[i].firstRow, .lastRow=_bands[i].lastRow, .compute=compute,
+				.barrierWait=std::chrono::nanoseconds{ _workerTimes[i].barrierWait.load(std::memory_order_relaxed) },
+				.population=(_profile.generations > 0u) ? _profile.populationSum[i] / static_cast<double>(_profile.generations) : 0.0 });
+		}
+
+		if(total.count() > 0)
+		{
+			report.runImbalance = static_cast<double>(slowest.count()) * static_cast<double>(_numThreads) / static_cast<double>(total.count());
+		}
+
+		return report;
+	}
+
+	SimulationCounters Simulation::counters() const noexcept
+	{
+		SimulationCounters counters{ .generations=_generationsCompleted.load(std::memory_order_relaxed) };
+
+		for(const auto& times : _workerTimes)
+		{
+			counters.compute += std::chrono::nanoseconds{ times.compute.load(std::memory_order_relaxed) };
+			counters.barrierWait += std::chrono::nanoseconds{ times.barrierWait.load(std::memory_order_relaxed) };
+		}
+
+		return counters;
+	}
+
+	uint8_t Simulation::countNeighbors(std::span<const CellState> world, uint64_t x, uint64_t y) const
+	{
+		auto wrap = [world](uint64_t x, uint64_t y, uint64_t width, uint64_t height)
+		{
+			if (x == std::numeric_limits<uint64_t>::max() || y == std::numeric_limits<uint64_t>::max()) { return 0u; }
+			if (x >= width || y >= height) { return 0u; }
+
+			return (world[(y * width) + x] == CellState::Alive) ? 1u : 0u;
+		};
+
+		uint8_t result{};
+
+		result += wrap(x - 1, y - 1, _width, _height);
+		result += wrap(x, y - 1, _width, _height);
+		result += wrap(x + 1, y - 1, _width, _height);
+		result += wrap(x - 1, y, _width, _height);
+		result += wrap(x + 1, y, _width, _height);
+		result += wrap(x - 1, y + 1, _width, _height);
+		result += wrap(x, y + 1, _width, _height);
+		result += wrap(x + 1, y + 1, _width, _height);
+
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,303 @@
+#ifndef LIFE_SIMULATION_HPP
+#define LIFE_SIMULATION_HPP
+
+#include <Cell.hpp>
+#include <Generation.hpp>
+#include <Kernels.hpp>
+#include <PerfCounters.hpp>
+#include <Random.hpp>
+#include <RateGovernor.hpp>
+#include <Trace.hpp>
+#include <TripleBuffer.hpp>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace life
+{
+    // How the simulation runs, fixed when it is constructed.
+    struct SimulationSettings
+    {
+        // Keep an age plane alongside the cells, updated in the same pass.
+        bool trackAges = false;
+
+        // Pin each worker to a CPU, spreading them evenly over the NUMA nodes.
+        bool pinThreads = false;
+
+        Kernel kernel = Kernel::Tiled;
+
+        // Columns per tile for the tiled kernel, zero to fit the L1 cache.
+        uint64_t tileWidth{};
+
+        // Measure every generation how evenly the work is spread over the workers, and count
+        // the live cells in each band, see loadReport().
+        bool profileLoad = false;
+
+        // Count hardware events around each worker's step, see perfCounts().
+        bool countEvents = false;
+
+        // Passes between moving the band boundaries so that each worker's band takes about
+        // as long as the others, measured since the last move. Zero keeps the bands even.
+        uint64_t rebalanceEvery{};
+
+        // Generations computed per pass over the world, see stepTemporal(). Above 1, only every
+        // that many generations is published. Needs the tiled kernel and no ages, otherwise it is 1.
+        uint64_t generationsPerPass = 1u;
+
+        // Memory for the cells of the three generations in flight, width * height cells each,
+        // one after the other, e.g. a shared-memory segment. Empty to allocate them as usual.
+        std::span<CellState> frameCells{};
+    };
+
+    // Where one worker ran and where its band of the world was placed. -1 where unknown.
+    struct WorkerPlacement
+    {
+        uint64_t firstRow{};
+        uint64_t lastRow{};
+        bool pinned = false;
+        int cpu = -1;
+        int cpuNode = -1;
+        int memoryNode = -1;
+    };
+
+    // Running totals since the simulation started. Safe to read from any thread.
+    struct SimulationCounters
+    {
+        uint64_t generations{};
+
+        // Summed over the workers: time spent computing, and time spent at the barrier, which
+        // includes waiting for the others, the completion hook and pacing to the target rate.
+        std::chrono::nanoseconds compute{};
+        std::chrono::nanoseconds barrierWait{};
+    };
+
+    // One worker's share of the run, see Simulation::loadReport().
+    struct WorkerLoad
+    {
+        uint64_t firstRow{};
+        uint64_t lastRow{};
+        std::chrono::nanoseconds compute{};
+        std::chrono::nanoseconds barrierWait{};
+
+        // Live cells in the band, averaged over the profiled generations.
+        double population{};
+    };
+
+    /*
+        How evenly the work was spread. Imbalance is the slowest worker's compute time over the
+        mean of all workers, 1 when perfectly balanced: every worker waits for the slowest one,
+        so at 1.5 a third of the workers' time is lost. Measured per generation, averaged and
+        at its worst, and over the whole run from each worker's total.
+    */
+    struct LoadReport
+    {
+        std::vector<WorkerLoad> workers;
+        uint64_t generations{};
+        double meanImbalance{};
+        double worstImbalance{};
+        double runImbalance{};
+    };
+
+    /*
+        Runs the simulation on a pool of worker threads, each responsible for a band of rows.
+        Completed generations are published through a triple buffer, so a renderer can pick
+        up the newest one at its own pace without ever holding up the workers.
+    */
+    class Simulation
+    {
+    public:
+        using CompletionHook = std::function<void(const Generation&)>;
+        using SnapshotHook = std::function<void(Generation&)>;
+        using BandHook = std::function<void(std::size_t worker, uint64_t firstRow, uint64_t lastRow, const Generation& previous, const Generation& next)>;
+
+        Simulation(uint64_t width, uint64_t height, std::size_t numThreads, const SimulationSettings& settings = {});
+        ~Simulation();
+
+        Simulation(const Simulation&) = delete;
+        Simulation& operator=(const Simulation&) = delete;
+        Simulation(Simulation&&) = delete;
+        Simulation& operator=(Simulation&&) = delete;
+
+        [[nodiscard]] bool tracksAges() const noexcept { return _tracksAges; }
+        [[nodiscard]] Kernel kernel() const noexcept { return _kernel; }
+        [[nodiscard]] uint64_t tileWidth() const noexcept { return _tileWidth; }
+        [[nodiscard]] uint64_t generationsPerPass() const noexcept { return _generationsPerPass; }
+
+        // Fills the first generation. Must be called before start().
+        void seed(const CounterRng& random, double density);
+
+        // Continues from a saved generation instead of seeding. Must be called before start().
+        void restore(const Generation& generation);
+
+        // Sets the workers going. Once stopped, the simulation can't be started again.
+        void start();
+        void stop();
+        void setPaused(bool paused);
+
+        // Generations per second, zero for as fast as possible. Must be called before start().
+        void setTargetRate(double generationsPerSecond) { _governor.setRate(generationsPerSecond / static_cast<double>(_generationsPerPass)); }
+
+        [[nodiscard]] bool paused() const noexcept { return _paused; }
+
+        // Has every worker record its phases into the tracer, which must outlive them. Must be called before start().
+        void setTracer(Tracer* tracer) noexcept { _tracer = tracer; }
+
+        // Runs on a worker thread after each published generation, while the other workers wait at the barrier.
+        void setCompletionHook(CompletionHook hook) { _completionHook = std::move(hook); }
+
+        /*
+            Runs on each worker once it has computed its rows of the next generation, before the
+            barrier, so per-row work can be spread over the workers instead of done in the
+            completion. Only rows firstRow to lastRow of next are complete. Must be set before start().
+        */
+        void setBandHook(BandHook hook) { _bandHook = std::move(hook); }
+
+        /*
+            Any thread: captures the next generation to complete, without stopping the workers.
+            While they compute the generation after it, each worker copies its band of the
+            captured one into a spare buffer. Once complete, the snapshot hook gets that buffer
+            and may swap its contents out, e.g. to write it in the background.
+        */
+        void requestSnapshot() noexcept { _snapshotRequested = true; }
+
+        // Runs on a worker thread, while the other workers wait at the barrier.
+        void setSnapshotHook(SnapshotHook hook) { _snapshotHook = std::move(hook); }
+
+        // The last completed generation. Only valid while the workers are stopped.
+        [[nodiscard]] const Generation& completed() const noexcept { return _frames.published(); }
+
+        // The generation the workers compute next. Only valid in the completion hook, or while the workers are stopped.
+        [[nodiscard]] const Generation& next() const noexcept { return _frames.back(); }
+
+        // Reader side: switches to the newest generation, returns false if there is nothing new.
+        bool acquireLatest() noexcept { return _frames.acquire(); }
+
+        // Reader side: stays unchanged until the next call to acquireLatest().
+        [[nodiscard]] const Generation& latest() const noexcept { return _frames.front(); }
+
+        [[nodiscard]] const std::vector<WorkerPlacement>& placement() const noexcept { return _placement; }
+
+        [[nodiscard]] SimulationCounters counters() const noexcept;
+
+        // The imbalance of the last generation, with profileLoad set. Safe to read from any thread.
+        [[nodiscard]] double imbalance() const noexcept { return _imbalance.load(std::memory_order_relaxed); }
+
+        // Only complete while the workers are stopped.
+        [[nodiscard]] LoadReport loadReport() const;
+
+        // Each worker's hardware events, with countEvents set. Only filled in once the workers are stopped.
+        [[nodiscard]] const std::vector<PerfCounts>& perfCounts() const noexcept { return _perfCounts; }
+
+        [[nodiscard]] uint64_t width() const noexcept { return _width; }
+        [[nodiscard]] uint64_t height() const noexcept { return _height; }
+
+        [[nodiscard]] uint8_t countNeighbors(std::span<const CellState> world, uint64_t x, uint64_t y) const;
+
+    private:
+        void work(std::stop_token stop, std::size_t index, int cpu, std::latch& placed);
+        void placeBand(std::size_t index, uint64_t firstRow, uint64_t lastRow, int cpu);
+
+        void step(uint64_t firstRow, uint64_t lastRow, TemporalScratch& scratch);
+
+        template<bool TrackAges>
+        void stepRows(uint64_t firstRow, uint64_t lastRow);
+        void captureRows(uint64_t firstRow, uint64_t lastRow);
+        void completeGeneration() noexcept;
+        void profileGeneration() noexcept;
+        void rebalance() noexcept;
+
+        struct Completion
+        {
+            Simulation* self;
+            void operator()() const noexcept { self->completeGeneration(); }
+        };
+
+        uint64_t _width;
+        uint64_t _height;
+        std::size_t _numThreads;
+        bool _tracksAges = false;
+        bool _profileLoad = false;
+        bool _countEvents = false;
+        uint64_t _rebalanceEvery{};
+        uint64_t _passesSinceRebalance{};
+        Kernel _kernel;
+        uint64_t _tileWidth;
+        uint64_t _generationsPerPass;
+        uint64_t _temporalTile;
+
+        TripleBuffer<Generation> _frames;
+        CompletionHook _completionHook;
+        BandHook _bandHook;
+        RateGovernor _governor;
+
+        // Set between the completion that starts a capture and the one that hands it to the hook.
+        SnapshotHook _snapshotHook;
+        Generation _snapshot;
+        std::atomic<bool> _snapshotRequested = false;
+        bool _capturing = false;
+
+        std::barrier<Completion> _barrier;
+        std::condition_variable_any _resumeCondition;
+        std::mutex _pauseLock;
+        std::atomic<bool> _paused = false;
+        std::atomic<bool> _stopping = false;
+        bool _started = false;
+
+        // Each entry is written by its own worker before the constructor returns.
+        std::vector<WorkerPlacement> _placement;
+
+        // Each worker adds to its own entry, on its own cache line, so timing costs no sharing.
+        struct alignas(64) WorkerTimes
+        {
+            std::atomic<int64_t> compute{};
+            std::atomic<int64_t> barrierWait{};
+
+            // Written before the barrier, read by the completion: this generation's compute time,
+            // the compute time since the bands last moved, and with profileLoad set, the band's population.
+            int64_t lastCompute{};
+            int64_t sinceRebalance{};
+            uint64_t population{};
+        };
+
+        std::vector<WorkerTimes> _workerTimes;
+
+        // Each entry is written by its own worker as it leaves.
+        std::vector<PerfCounts> _perfCounts;
+
+        // Rows each worker steps. Read by each worker at the start of every generation, moved only by the completion.
+        struct Band
+        {
+            uint64_t firstRow{};
+            uint64_t lastRow{};
+        };
+
+        std::vector<Band> _bands;
+
+        // Only touched by the completion, with profileLoad set.
+        struct LoadProfile
+        {
+            uint64_t generations{};
+            double imbalanceSum{};
+            double worstImbalance{};
+            std::vector<double> populationSum;
+        };
+
+        LoadProfile _profile;
+        std::atomic<double> _imbalance = 0.0;
+        Tracer* _tracer = nullptr;
+        std::atomic<uint64_t> _generationsCompleted = 0u;
+
+        std::vector<std::jthread> _threadPool;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <Stream.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+namespace life
+{
+	namespace
+	{
+		GenerationView viewOf(const Generation& generation, uint64_t width, uint64_t height) noexcept
+		{
+			return GenerationView{ .cells=generation.cells, .ages=generation.ages, .width=width, .height=height, .number=generation.number };
+		}
+
+		// Passes each published generation from the completion to the consumer, and holds the workers until it is done with it.
+		struct Handoff
+		{
+			std::mutex lock;
+			std::condition_variable condition;
+			const Generation* ready = nullptr;
+			bool closing = false;
+		};
+
+		// Lets go of a held generation and stops the workers, when the consumer stops pulling.
+		struct Closer
+		{
+			Simulation& simulation;
+			Handoff& handoff;
+
+			~Closer()
+			{
+				{
+					std::scoped_lock lock{handoff.lock};
+					handoff.closing = true;
+				}
+
+				handoff.condition.notify_all();
+				simulation.stop();
+				simulation.setCompletionHook({});
+			}
+		};
+	}
+
+	Generator<GenerationView> streamGenerations(Simulation& simulation, uint64_t every)
+	{
+		const auto width = simulation.width(), height = simulation.height();
+
+		// The workers haven't started, so the seeded generation can be read in place.
+		const auto& first = simulation.completed();
+		co_yield viewOf(first, width, height);
+
+		Handoff handoff;
+		every = std::max(every, uint64_t{ 1u });
+
+		// Only ever runs in the completion, so one at a time.
+		simulation.setCompletionHook([&handoff, every, next = first.number + every](const Generation& published) mutable
+		{
+			if(published.number < next) { return; }
+			next = published.number + every;
+
+			std::unique_lock lock{handoff.lock};
+			if(handoff.closing) { return; }
+
+			handoff.ready = &published;
+			handoff.condition.notify_all();
+			handoff.condition.wait(lock, [&handoff]() { return handoff.ready == nullptr || handoff.closing; });
+		});
+
+		const Closer closer{ .simulation=simulation, .handoff=handoff };
+		simulation.start();
+
+		for(;;)
+		{
+			const Generation* published = nullptr;
+			{
+				std::unique_lock lock{handoff.lock};
+				handoff.condition.wait(lock, [&handoff]() { return handoff.ready != nullptr; });
+				published = handoff.ready;
+			}
+
+			co_yield viewOf(*published, width, height);
+
+			{
+				std::scoped_lock lock{handoff.lock};
+				handoff.ready = nullptr;
+			}
+
+			handoff.condition.notify_all();
+		}
+	}
+}
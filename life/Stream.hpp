@@ -0,0 +1,46 @@
+#ifndef LIFE_STREAM_HPP
+#define LIFE_STREAM_HPP
+
+#include <Cell.hpp>
+#include <Generator.hpp>
+#include <Simulation.hpp>
+#include <cstdint>
+#include <span>
+
+namespace life
+{
+    // A read-only look at one generation, straight into the engine's buffers.
+    struct GenerationView
+    {
+        std::span<const CellState> cells;
+
+        // Empty unless the simulation tracks ages.
+        std::span<const uint8_t> ages;
+
+        uint64_t width{};
+        uint64_t height{};
+        uint64_t number{};
+
+        [[nodiscard]] std::span<const CellState> row(uint64_t y) const noexcept { return cells.subspan(y * width, width); }
+        [[nodiscard]] CellState at(uint64_t x, uint64_t y) const noexcept { return cells[y * width + x]; }
+    };
+
+    /*
+        Runs a seeded or restored simulation that hasn't been started, and yields its first
+        generation, then every generation at least `every` past the one yielded before. With
+        generationsPerPass above 1, only whole passes are published, so numbers may skip.
+
+        Nothing runs until the first view is pulled. While the consumer holds a view, the
+        workers wait at the barrier with that generation published, so nothing is copied and
+        the view stays valid until the next one is pulled. Destroying the generator stops the
+        simulation for good. The simulation's completion hook is taken over until then.
+
+            for(const auto& view : streamGenerations(simulation, 10u))
+            {
+                if(view.number >= 1000u) { break; }
+            }
+    */
+    [[nodiscard]] Generator<GenerationView> streamGenerations(Simulation& simulation, uint64_t every = 1u);
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include <Trace.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <fmt/format.h>
+
+namespace life
+{
+	namespace
+	{
+		struct Attachment
+		{
+			void* buffer = nullptr;
+			Tracer::Clock::time_point origin{};
+		};
+
+		thread_local Attachment attachment;
+
+		constexpr const char* phaseName(TracePhase phase)
+		{
+			switch (phase)
+			{
+			case TracePhase::Compute: return "compute";
+			case TracePhase::BarrierWait: return "barrier wait";
+			case TracePhase::Completion: return "completion";
+			case TracePhase::Publish: return "publish";
+			case TracePhase::Acquire: return "acquire";
+			case TracePhase::Render: return "render";
+			}
+
+			return "unknown";
+		}
+
+		// Trace-event timestamps are in microseconds.
+		double microseconds(int64_t nanoseconds)
+		{
+			return static_cast<double>(nanoseconds) / 1000.0;
+		}
+	}
+
+	Tracer::Tracer() : _origin(Clock::now()) {}
+
+	Tracer::~Tracer() = default;
+
+	void Tracer::attach(std::string threadName)
+	{
+		Buffer* buffer = nullptr;
+		{
+			std::scoped_lock lock{_lock};
+			buffer = &_buffers.emplace_back(Buffer{ .threadName=std::move(threadName), .events={}, .recorded=0u });
+		}
+
+		buffer->events.resize(eventsPerThread);
+		attachment = Attachment{ .buffer=buffer, .origin=_origin };
+	}
+
+	void Tracer::detach() noexcept
+	{
+		attachment = Attachment{};
+	}
+
+	bool tracing() noexcept
+	{
+		return attachment.buffer != nullptr;
+	}
+
+	void trace(TracePhase phase, Tracer::Clock::time_point begin, Tracer::Clock::time_point end) noexcept
+	{
+		if (attachment.buffer == nullptr) { return; }
+
+		auto& buffer = *static_cast<Tracer::Buffer*>(attachment.buffer);
+		const auto since = [](Tracer::Clock::time_point time) { return std::chrono::duration_cast<std::chrono::nanoseconds>(time - attachment.origin).count(); };
+
+		buffer.events[buffer.recorded % Tracer::eventsPerThread] = Tracer::Event{ .begin=since(begin), .end=since(end), .phase=phase };
+		++buffer.recorded;
+	}
+
+	uint64_t Tracer::recorded() const
+	{
+		std::scoped_lock lock{_lock};
+
+		uint64_t total = 0u;
+		for (const auto& buffer : _buffers) { total += buffer.recorded; }
+		return total;
+	}
+
+	void Tracer::write(const std::string& path) const
+	{
+		const std::unique_ptr<std::FILE, decltype(&std::fclose)> file{ std::fopen(path.c_str(), "w"), &std::fclose };
+		if (!file)
+		{
+			throw std::runtime_error{ fmt::format("Can't write the trace to '{}'", path) };
+		}
+
+		std::scoped_lock lock{_lock};
+
+		fmt::print(file.get(), "{{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+		fmt::print(file.get(), "{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{{\"name\":\"life\"}}}}");
+
+		auto thread = 0uz;
+		for (const auto& buffer : _buffers)
+		{
+			++thread;
+			fmt::print(file.get(), ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}", thread, buffer.threadName);
+
+			// Once the buffer wrapped, the oldest event sits right after the newest.
+			const auto kept = std::min(buffer.recorded, static_cast<uint64_t>(eventsPerThread));
+			for (auto i = buffer.recorded - kept; i < buffer.recorded; ++i)
+			{
+				const auto& event = buffer.events[i % eventsPerThread];
+				fmt::print(file.get(), ",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+					phaseName(event.phase), thread, microseconds(event.begin), microseconds(event.end - event.begin));
+			}
+		}
+
+		fmt::print(file.get(), "\n]}}\n");
+
+		if (std::ferror(file.get()) != 0)
+		{
+			throw std::runtime_error{ fmt::format("Can't write the trace to '{}'", path) };
+		}
+	}
+}
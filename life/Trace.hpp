@@ -0,0 +1,112 @@
+#ifndef LIFE_TRACE_HPP
+#define LIFE_TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace life
+{
+    enum class TracePhase : uint8_t
+    {
+        Compute,        // A worker stepping its band.
+        BarrierWait,    // A worker waiting for the others, including the completion below.
+        Completion,     // The barrier's completion: hooks, publishing and pacing.
+        Publish,        // Handing a finished generation to the triple buffer.
+        Acquire,        // The renderer picking up the newest generation.
+        Render          // Drawing a frame.
+    };
+
+    /*
+        Records spans of time per thread and writes them as Chrome trace-event JSON, which
+        chrome://tracing and ui.perfetto.dev open. Each thread records into its own buffer,
+        without locks or allocation, keeping only its newest events once the buffer is full.
+        Threads that never attached record nothing, at the cost of one check per span.
+    */
+    class Tracer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Events kept per thread, the newest ones win.
+        static constexpr auto eventsPerThread = 1uz << 17u;
+
+        Tracer();
+        ~Tracer();
+
+        Tracer(const Tracer&) = delete;
+        Tracer& operator=(const Tracer&) = delete;
+        Tracer(Tracer&&) = delete;
+        Tracer& operator=(Tracer&&) = delete;
+
+        // Makes the calling thread record into a buffer of its own, shown under the given name.
+        void attach(std::string threadName);
+
+        // Stops the calling thread recording. A thread must detach before the tracer is destroyed, or exit.
+        static void detach() noexcept;
+
+        // Writes every thread's events. Only while no thread is recording. Throws std::runtime_error if it can't.
+        void write(const std::string& path) const;
+
+        [[nodiscard]] uint64_t recorded() const;
+
+    private:
+        struct Event
+        {
+            int64_t begin;
+            int64_t end;
+            TracePhase phase;
+        };
+
+        struct Buffer
+        {
+            std::string threadName;
+            std::vector<Event> events;
+            uint64_t recorded{};
+        };
+
+        friend void trace(TracePhase phase, Clock::time_point begin, Clock::time_point end) noexcept;
+
+        Clock::time_point _origin;
+
+        // Attaching is the only thing that takes the lock; a deque keeps the buffers where they are.
+        mutable std::mutex _lock;
+        std::deque<Buffer> _buffers;
+    };
+
+    // Records a span on the calling thread, if it is attached to a tracer.
+    void trace(TracePhase phase, Tracer::Clock::time_point begin, Tracer::Clock::time_point end) noexcept;
+
+    // Whether the calling thread is attached, so callers can skip reading the clock.
+    [[nodiscard]] bool tracing() noexcept;
+
+    // Records the span of its own lifetime.
+    class TraceScope
+    {
+    public:
+        explicit TraceScope(TracePhase phase) noexcept : _phase(phase), _active(tracing())
+        {
+            if (_active) { _begin = Tracer::Clock::now(); }
+        }
+
+        ~TraceScope()
+        {
+            if (_active) { trace(_phase, _begin, Tracer::Clock::now()); }
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+        TraceScope(TraceScope&&) = delete;
+        TraceScope& operator=(TraceScope&&) = delete;
+
+    private:
+        TracePhase _phase;
+        bool _active;
+        Tracer::Clock::time_point _begin{};
+    };
+}
+
+#endif
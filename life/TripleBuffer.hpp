@@ -0,0 +1,60 @@
+#ifndef LIFE_TRIPLEBUFFER_HPP
+#define LIFE_TRIPLEBUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace life
+{
+    /*
+        Lock-free hand-off between one writer and one reader. The writer fills the back slot
+        and publishes it into the middle; the reader swaps the middle with its front slot
+        whenever something new was published. The three indices are always a permutation of
+        {0, 1, 2}, so neither side ever waits for, or writes to, a slot the other one holds.
+
+        The writer may keep reading the slot it published last: the reader only ever reads it.
+    */
+    template<typename T>
+    class TripleBuffer
+    {
+    public:
+        // Writer side: the slot being filled.
+        [[nodiscard]] T& back() noexcept { return _slots[_back]; }
+        [[nodiscard]] const T& back() const noexcept { return _slots[_back]; }
+
+        // Writer side: the slot published last, which the reader may be looking at as well.
+        [[nodiscard]] const T& published() const noexcept { return _slots[_published]; }
+
+        // Writer side: hands the back slot over and takes whichever slot the reader is not using.
+        void publish() noexcept
+        {
+            _published = _back;
+            _back = static_cast<uint8_t>(_middle.exchange(static_cast<uint8_t>(_back | fresh), std::memory_order_acq_rel) & index);
+        }
+
+        // Reader side: switches to the newest published slot. Returns false if nothing new arrived.
+        bool acquire() noexcept
+        {
+            if((_middle.load(std::memory_order_relaxed) & fresh) == 0u) { return false; }
+
+            _front = static_cast<uint8_t>(_middle.exchange(_front, std::memory_order_acq_rel) & index);
+            return true;
+        }
+
+        // Reader side: the slot being looked at.
+        [[nodiscard]] const T& front() const noexcept { return _slots[_front]; }
+
+        // Every slot, for setting them up before either side starts.
+        [[nodiscard]] std::array<T, 3>& slots() noexcept { return _slots; }
+
+    private:
+        static constexpr uint8_t index = 0b011u, fresh = 0b100u;
+
+        std::array<T, 3> _slots{};
+        uint8_t _back = 0u, _published = 1u, _front = 2u;
+        std::atomic<uint8_t> _middle = 1u;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <WorldBuffer.hpp>
+#include <atomic>
+#include <fstream>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace life
+{
+	namespace
+	{
+		std::atomic<HugePages> mode = HugePages::Transparent;
+		std::atomic<uint64_t> explicitBytes = 0u, transparentBytes = 0u, ordinaryBytes = 0u;
+
+		std::size_t roundUp(std::size_t bytes)
+		{
+			return (bytes + hugePageSize - 1u) / hugePageSize * hugePageSize;
+		}
+
+#if defined(__linux__)
+		// Maps more than needed, then trims the ends, so the mapping starts on a huge page boundary.
+		// The kernel can only use a transparent huge page for a whole, aligned one.
+		void* mapAligned(std::size_t length)
+		{
+			auto* mapping = static_cast<std::byte*>(mmap(nullptr, length + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+			if (mapping == MAP_FAILED) { return nullptr; }
+
+			const auto offset = (hugePageSize - (reinterpret_cast<uintptr_t>(mapping) % hugePageSize)) % hugePageSize;
+
+			if (offset > 0u) { munmap(mapping, offset); }
+			munmap(mapping + offset + length, hugePageSize - offset);
+
+			return mapping + offset;
+		}
+
+		void* mapHuge(std::size_t length, HugePages requested)
+		{
+			if (requested == HugePages::Explicit)
+			{
+				// Asks for 2 MiB pages in particular, the default huge page size may be larger.
+				auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+				flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+				auto* mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+				if (mapping != MAP_FAILED)
+				{
+					explicitBytes += length;
+					return mapping;
+				}
+			}
+
+			auto* mapping = mapAligned(length);
+			if (mapping == nullptr) { throw std::bad_alloc{}; }
+
+			const auto advice = (requested == HugePages::Off) ? MADV_NOHUGEPAGE : MADV_HUGEPAGE;
+			if (madvise(mapping, length, advice) == 0 && advice == MADV_HUGEPAGE) { transparentBytes += length; }
+			else { ordinaryBytes += length; }
+
+			return mapping;
+		}
+#endif
+	}
+
+	void setHugePages(HugePages requested) noexcept
+	{
+		mode = requested;
+	}
+
+	HugePages hugePages() noexcept
+	{
+		return mode;
+	}
+
+	void* allocateWorld(std::size_t bytes, std::size_t alignment)
+	{
+#if defined(__linux__)
+		if (bytes >= hugePageSize && alignment <= hugePageSize)
+		{
+			return mapHuge(roundUp(bytes), mode);
+		}
+#endif
+		return ::operator new(bytes, std::align_val_t{ alignment });
+	}
+
+	void freeWorld(void* memory, std::size_t bytes, std::size_t alignment) noexcept
+	{
+#if defined(__linux__)
+		if (bytes >= hugePageSize && alignment <= hugePageSize)
+		{
+			munmap(memory, roundUp(bytes));
+			return;
+		}
+#endif
+		::operator delete(memory, std::align_val_t{ alignment });
+	}
+
+	HugePageReport hugePageReport()
+	{
+		HugePageReport report{ .explicitBytes=explicitBytes, .transparentBytes=transparentBytes, .ordinaryBytes=ordinaryBytes };
+
+#if defined(__linux__)
+		// Whether the kernel actually granted transparent huge pages only shows once the memory is written.
+		std::ifstream rollup{ "/proc/self/smaps_rollup" };
+		for (std::string field; rollup >> field; )
+		{
+			if (field == "AnonHugePages:")
+			{
+				uint64_t kibibytes{};
+				rollup >> kibibytes;
+				report.transparentBacked = kibibytes * 1024u;
+				break;
+			}
+		}
+#endif
+
+		return report;
+	}
+}
@@ -0,0 +1,118 @@
+#ifndef LIFE_WORLDBUFFER_HPP
+#define LIFE_WORLDBUFFER_HPP
+
+#include <Cell.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace life
+{
+    // How large world buffers are backed. Only Linux can use huge pages; elsewhere every mode acts like Off.
+    enum class HugePages : uint8_t
+    {
+        Off,            // Ordinary pages, with transparent huge pages explicitly declined.
+        Transparent,    // Ask the kernel to back the buffer with transparent huge pages (madvise).
+        Explicit        // Reserved huge pages (MAP_HUGETLB), falling back to Transparent if none are left.
+    };
+
+    // Buffers at least this large are mapped directly, aligned to it, and use the HugePages mode.
+    constexpr std::size_t hugePageSize = std::size_t{2} << 20u;
+
+    // Applies to buffers allocated afterwards. Default: Transparent.
+    void setHugePages(HugePages mode) noexcept;
+    [[nodiscard]] HugePages hugePages() noexcept;
+
+    // What the large buffers allocated since startup got, in bytes.
+    struct HugePageReport
+    {
+        uint64_t explicitBytes{};       // Mapped with reserved huge pages.
+        uint64_t transparentBytes{};    // Mapped with a request for transparent huge pages.
+        uint64_t ordinaryBytes{};       // Mapped with ordinary pages, by choice or after every request failed.
+        uint64_t transparentBacked{};   // Actually backed by transparent huge pages, process wide. Linux only.
+    };
+
+    [[nodiscard]] HugePageReport hugePageReport();
+
+    void* allocateWorld(std::size_t bytes, std::size_t alignment);
+    void freeWorld(void* memory, std::size_t bytes, std::size_t alignment) noexcept;
+
+    /*
+        Default-initializes new elements instead of zeroing them, which for cells and ages means
+        leaving them untouched. The pages of a large buffer are then only placed in memory, on the
+        NUMA node of whichever thread writes them first, once that thread gets to them.
+        Buffers of at least hugePageSize are mapped directly, as the HugePages mode asks.
+
+        An allocator given a block of memory, e.g. part of a shared-memory segment, hands out
+        that block instead, for a buffer that is sized once, and never frees it. Copies of
+        such a buffer get memory of their own.
+    */
+    template<typename T>
+    struct WorldAllocator
+    {
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        WorldAllocator() = default;
+        explicit WorldAllocator(std::span<T> block) noexcept : _block(block) {}
+
+        // Only an allocator of the same type can share its block.
+        template<typename U>
+        explicit(false) WorldAllocator(const WorldAllocator<U>& /*other*/) noexcept {}
+
+        [[nodiscard]] WorldAllocator select_on_container_copy_construction() const noexcept { return {}; }
+
+        [[nodiscard]] T* allocate(std::size_t count)
+        {
+            if(_block.data() != nullptr)
+            {
+                if(count > _block.size()) { throw std::bad_alloc{}; }
+                return _block.data();
+            }
+
+            return static_cast<T*>(allocateWorld(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* elements, std::size_t count) noexcept
+        {
+            if(elements == _block.data()) { return; }
+
+            freeWorld(elements, count * sizeof(T), alignof(T));
+        }
+
+        template<typename U>
+        void construct(U* element) noexcept(std::is_nothrow_default_constructible_v<U>)
+        {
+            ::new(static_cast<void*>(element)) U;
+        }
+
+        template<typename U, typename... Args>
+        void construct(U* element, Args&&... args)
+        {
+            ::new(static_cast<void*>(element)) U(std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]] std::span<T> block() const noexcept { return _block; }
+
+        template<typename U>
+        bool operator==(const WorldAllocator<U>& other) const noexcept
+        {
+            return static_cast<const void*>(_block.data()) == static_cast<const void*>(other.block().data());
+        }
+
+    private:
+        std::span<T> _block;
+    };
+
+    // Storage for the planes of a generation.
+    using CellBuffer = std::vector<CellState, WorldAllocator<CellState>>;
+    using AgeBuffer = std::vector<uint8_t, WorldAllocator<uint8_t>>;
+}
+
+#endif
@@ -1,4 +1,7 @@
 #include <GameOfLife.hpp>
+#include <Census.hpp>
+#include <Checkpoint.hpp>
+#include <Distributed.hpp>
 
 #include <cstdlib>
 #include <cerrno>
@@ -7,6 +10,8 @@
 #include <stdexcept>
 #include <string_view>
 #include <limits>
+#include <thread>
+#include <algorithm>
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -22,12 +27,98 @@ constexpr int def_worldH = 192;
 	--height
 
 	Default: 256 x 192 
+
+	The starting world is random, and can be reproduced using:
+
+	--seed		Default: taken from the clock, and printed at startup.
+	--density	Fraction of cells that start alive. Default: 0.5
+
+	The speed of the simulation is set using:
+
+	--gps		Generations per second, or 'unlimited'. Default: unlimited
+
+	Runs can be recorded, uncompressed, using:
+
+	--record	Stream the rendered frames to a file, or '-' for stdout. Files ending in
+			.ppm get a stream of PPM images, anything else is YUV4MPEG2 (.y4m).
+			With --gps, one frame per shown generation, otherwise one per displayed frame.
+
+	Every generation can be logged, compactly, and played back later using:
+
+	--log			Log file to write. Stores a keyframe every so often and only the cells
+				that changed in between.
+	--keyframe-interval	Generations between keyframes. Default: 1000
+	--replay		Log file to play back instead of simulating. Use the arrow keys to step,
+				Page Up/Down to jump by a keyframe interval, Home/End to jump to either end.
+
+	Long runs can be checkpointed, without pausing the simulation, resumed and counted using:
+
+	--checkpoint-every	Generations between checkpoints. A checkpoint is also written on SIGTERM.
+	--checkpoint-file	Where to write them. Default: life.checkpoint
+	--resume		Checkpoint to continue from, instead of a random world.
+	--census		Checkpoint to print the census of, as the C key does, instead of
+				opening the window.
+
+	Other processes can read the live world, without slowing the simulation down, using:
+
+	--share		Name of a POSIX shared-memory segment, e.g. /life, that the simulation
+			computes every generation in. See SharedWorld.hpp for its layout.
+			Not available with --replay.
+
+	--trace		Write a Chrome trace of what every thread spent its time on to this file at
+			exit. Open it in chrome://tracing or ui.perfetto.dev.
+	--metrics	Local port to serve Prometheus metrics on, at http://127.0.0.1:<port>/metrics.
+
+	Each generation is computed by one of these kernels, chosen using:
+
+	--kernel	'tiled' or 'reference', which is simpler but much slower. Default: tiled
+	--tile-width	Columns per tile for the tiled kernel, up to 65536, or 'auto' to fit
+			the L1 data cache. Default: auto
+	--temporal	Generations computed per pass over the world, up to 64. Each tile is
+			stepped that many times while it is in the cache, so only every so
+			many generations is shown. Not with --heatmap or --log. Default: 1
+
+	The world is split into one band of rows per worker. Busy regions take longer, so the bands
+	can be resized as the run goes on:
+
+	--rebalance	Passes over the world (see --temporal) between moving the band boundaries,
+			so that every band takes about as long as the others to compute. With
+			--pin-threads, rows only move between workers on the same NUMA node.
+			0 keeps the bands even. Default: 0
+
+	Memory for large worlds is backed by huge pages, to save on TLB misses, as chosen by:
+
+	--huge-pages	'off', 'transparent' or 'explicit' (reserved pages, falling back to
+			transparent ones). Linux only. Default: transparent
+
+	Large worlds can be run without a window, split over several processes that swap the
+	rows along their edges every generation, using:
+
+	--distributed	Number of processes. Each gets a band of rows. Linux and other Unix only.
+			Not with --kernel reference, --temporal, --heatmap, --resume or --replay.
+	--generations	Generations to run before stopping. Default: 1000
+	--output	Checkpoint to save the last generation to, which --resume can open. The
+			bands are streamed into it, the world is never gathered in one process.
+
+	Flags, which take no value:
+
+	--heatmap	Track the age of every cell and colour the world by it. Toggle with M.
+	--pin-threads	Pin the simulation's workers to CPUs, spread evenly over the NUMA nodes,
+			and print where each worker and its part of the world ended up.
+			--rebalance then keeps each node's rows on that node.
+	--profile-load	Measure how evenly the work is spread over the workers every generation.
+			Shown in the HUD, and reported per worker at exit.
+	--perf-counters	Count hardware events around the step kernel, and report IPC and cycles
+			and misses per cell at exit. Linux only, using perf_event_open.
 */
 int main(int argc, const char** argv)
 {
 	int wWidth = def_worldW;
 	int wHeight = def_worldH;
 
+	life::Options options{};
+	bool seedGiven = false;
+
 	const auto args = std::span<const char*>{ argv, static_cast<size_t>(argc) };
 
 	// Validate arguments and catch any user errors.
@@ -42,10 +133,31 @@ int main(int argc, const char** argv)
 			{
 				if(argumentToSet.empty())
 				{
-					if (arg == "--width" || arg == "--height")
+					if (arg == "--width" || arg == "--height" || arg == "--seed" || arg == "--density" || arg == "--gps"
+						|| arg == "--record" || arg == "--log" || arg == "--keyframe-interval" || arg == "--replay"
+						|| arg == "--checkpoint-every" || arg == "--checkpoint-file" || arg == "--resume" || arg == "--huge-pages"
+						|| arg == "--kernel" || arg == "--tile-width" || arg == "--temporal" || arg == "--distributed"
+						|| arg == "--generations" || arg == "--output" || arg == "--share" || arg == "--metrics"
+						|| arg == "--trace" || arg == "--rebalance" || arg == "--census")
 					{
 						argumentToSet = arg;
 					}
+					else if (arg == "--heatmap")
+					{
+						options.heatmap = true;
+					}
+					else if (arg == "--pin-threads")
+					{
+						options.pinThreads = true;
+					}
+					else if (arg == "--profile-load")
+					{
+						options.profileLoad = true;
+					}
+					else if (arg == "--perf-counters")
+					{
+						options.countEvents = true;
+					}
 					
 					continue;
 				}
@@ -77,6 +189,200 @@ int main(int argc, const char** argv)
 						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
 					}
 				}
+				else if(argumentToSet == "--seed")
+				{
+					char* end = nullptr;
+					errno = 0;
+					auto result = std::strtoull(arg.data(), &end, base10);
+					if(errno != ERANGE && end != arg.data() && *end == '\0' && !arg.starts_with('-'))
+					{
+						options.seed = result;
+						seedGiven = true;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--density")
+				{
+					char* end = nullptr;
+					auto result = std::strtod(arg.data(), &end);
+					if(end != arg.data() && *end == '\0' && result >= 0.0 && result <= 1.0)
+					{
+						options.density = result;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--gps")
+				{
+					char* end = nullptr;
+					auto result = (arg == "unlimited") ? 0.0 : std::strtod(arg.data(), &end);
+					if(arg == "unlimited" || (end != arg.data() && *end == '\0' && result > 0.0))
+					{
+						options.generationsPerSecond = result;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--record")
+				{
+					options.recordPath = arg;
+				}
+				else if(argumentToSet == "--log")
+				{
+					options.logPath = arg;
+				}
+				else if(argumentToSet == "--keyframe-interval")
+				{
+					char* end = nullptr;
+					errno = 0;
+					auto result = std::strtoull(arg.data(), &end, base10);
+					if(errno != ERANGE && end != arg.data() && *end == '\0' && !arg.starts_with('-') && result > 0u)
+					{
+						options.keyframeInterval = result;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--replay")
+				{
+					options.replayPath = arg;
+				}
+				else if(argumentToSet == "--checkpoint-every")
+				{
+					char* end = nullptr;
+					errno = 0;
+					auto result = std::strtoull(arg.data(), &end, base10);
+					if(errno != ERANGE && end != arg.data() && *end == '\0' && !arg.starts_with('-') && result > 0u)
+					{
+						options.checkpointEvery = result;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--checkpoint-file")
+				{
+					options.checkpointPath = arg;
+				}
+				else if(argumentToSet == "--resume")
+				{
+					options.resumePath = arg;
+				}
+				else if(argumentToSet == "--kernel")
+				{
+					if(arg == "reference") { options.kernel = life::Kernel::Reference; }
+					else if(arg == "tiled") { options.kernel = life::Kernel::Tiled; }
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--tile-width")
+				{
+					char* end = nullptr;
+					errno = 0;
+					auto result = (arg == "auto") ? 0u : std::strtoull(arg.data(), &end, base10);
+					if(arg == "auto" || (errno != ERANGE && end != arg.data() && *end == '\0' && !arg.starts_with('-') && result > 0u && result <= life::maxTileWidth))
+					{
+						options.tileWidth = result;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--temporal")
+				{
+					char* end = nullptr;
+					errno = 0;
+					auto result = std::strtoull(arg.data(), &end, base10);
+					if(errno != ERANGE && end != arg.data() && *end == '\0' && !arg.starts_with('-') && result > 0u && result <= life::maxGenerationsPerPass)
+					{
+						options.generationsPerPass = result;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--huge-pages")
+				{
+					if(arg == "off") { options.hugePages = life::HugePages::Off; }
+					else if(arg == "transparent") { options.hugePages = life::HugePages::Transparent; }
+					else if(arg == "explicit") { options.hugePages = life::HugePages::Explicit; }
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--rebalance")
+				{
+					char* end = nullptr;
+					errno = 0;
+					auto result = std::strtoull(arg.data(), &end, base10);
+					if(errno != ERANGE && end != arg.data() && *end == '\0' && !arg.starts_with('-'))
+					{
+						options.rebalanceEvery = result;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--distributed" || argumentToSet == "--generations")
+				{
+					char* end = nullptr;
+					errno = 0;
+					auto result = std::strtoull(arg.data(), &end, base10);
+					if(errno != ERANGE && end != arg.data() && *end == '\0' && !arg.starts_with('-') && result > 0u)
+					{
+						(argumentToSet == "--distributed" ? options.processes : options.generations) = result;
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
+				else if(argumentToSet == "--output")
+				{
+					options.outputPath = arg;
+				}
+				else if(argumentToSet == "--census")
+				{
+					options.censusPath = arg;
+				}
+				else if(argumentToSet == "--share")
+				{
+					options.shareName = arg;
+				}
+				else if(argumentToSet == "--trace")
+				{
+					options.tracePath = arg;
+				}
+				else if(argumentToSet == "--metrics")
+				{
+					char* end = nullptr;
+					errno = 0;
+					auto result = std::strtoull(arg.data(), &end, base10);
+					if(errno != ERANGE && end != arg.data() && *end == '\0' && !arg.starts_with('-') && result > 0u && result <= std::numeric_limits<uint16_t>::max())
+					{
+						options.metricsPort = static_cast<uint16_t>(result);
+					}
+					else
+					{
+						throw std::invalid_argument{ fmt::format("Option: '{}', value: '{}'", argumentToSet, arg) };
+					}
+				}
 				// NOLINTEND(bugprone-suspicious-stringview-data-usage)
 				
 				argumentToSet.clear();
@@ -90,33 +396,99 @@ int main(int argc, const char** argv)
 		}
 	}
 
-	int cw{}, ch{};
+	// A saved world is counted without a window, and may be far larger than one could show.
+	if (!options.censusPath.empty())
+	{
+		try
+		{
+			const auto checkpoint = life::readCheckpoint(options.censusPath);
+			const auto census = life::takeCensus(checkpoint.generation.cells, checkpoint.width, checkpoint.height, std::thread::hardware_concurrency());
+			life::printCensus(stdout, checkpoint.generation.number, census);
+		}
+		catch (const std::runtime_error& err)
+		{
+			fmt::println(stderr, "{}", err.what());
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
 
-	constexpr int def_windowW = 1024;
-	constexpr int def_windowH = 768;
+	// A replay always has the size of the world it logged.
+	if (!options.replayPath.empty())
+	{
+		try
+		{
+			const auto header = life::LogReader::readHeader(options.replayPath);
+			if (header.width >= static_cast<uint64_t>(std::numeric_limits<int>::max()) || header.height >= static_cast<uint64_t>(std::numeric_limits<int>::max()))
+			{
+				throw std::runtime_error{ fmt::format("'{}' is too large to replay", options.replayPath) };
+			}
 
-	// Calculate if cell sizes larger than 1x1 pixels are needed.
-	if (wWidth < def_windowW)
+			wWidth = static_cast<int>(header.width);
+			wHeight = static_cast<int>(header.height);
+		}
+		catch (const std::runtime_error& err)
+		{
+			fmt::println(stderr, "{}", err.what());
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+	// So does a resumed run.
+	if (!options.resumePath.empty() && options.replayPath.empty())
 	{
-		cw = def_windowW / wWidth;
+		try
+		{
+			const auto checkpoint = life::readCheckpointHeader(options.resumePath);
+			if (checkpoint.width >= static_cast<uint64_t>(std::numeric_limits<int>::max()) || checkpoint.height >= static_cast<uint64_t>(std::numeric_limits<int>::max()))
+			{
+				throw std::runtime_error{ fmt::format("'{}' is too large to resume", options.resumePath) };
+			}
+
+			wWidth = static_cast<int>(checkpoint.width);
+			wHeight = static_cast<int>(checkpoint.height);
+			fmt::println((options.recordPath == "-") ? stderr : stdout, "Resuming from generation {}", checkpoint.generation.number);
+		}
+		catch (const std::runtime_error& err)
+		{
+			fmt::println(stderr, "{}", err.what());
+			std::exit(EXIT_FAILURE);
+		}
 	}
-	else
+
+	constexpr int def_windowW = 1024;
+	constexpr int def_windowH = 768;
+
+	// Start with the largest cells that fit the whole world in the window. The window itself
+	// always uses 1x1 pixels; cells are magnified while rendering, so they can be zoomed.
+	options.cellSize = static_cast<uint64_t>(std::max(1, std::min(def_windowW / wWidth, def_windowH / wHeight)));
+
+	if (!seedGiven)
 	{
-		cw = 1;
+		options.seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
 	}
 
-	if (wHeight < def_windowH)
+	// When the video goes to stdout, everything else goes to stderr.
+	if (options.replayPath.empty() && options.resumePath.empty())
 	{
-		ch = def_windowH / wHeight;
+		fmt::println((options.recordPath == "-") ? stderr : stdout, "Seed: {} (pass --seed {} to run this world again)", options.seed, options.seed);
 	}
-	else
+
+	options.worldWidth = static_cast<uint64_t>(wWidth);
+	options.worldHeight = static_cast<uint64_t>(wHeight);
+
+	// Must be set before the world is allocated.
+	life::setHugePages(options.hugePages);
+
+	if (options.processes > 0u)
 	{
-		ch = 1;
+		return life::runDistributed(options);
 	}
 
-	life::GameOfLife g{static_cast<uint32_t>(wWidth), static_cast<uint32_t>(wHeight)};
+	life::GameOfLife g{options};
 
-	if (g.Construct(def_windowW / cw, def_windowH / ch, cw, ch, false, true) == olc::rcode::OK)
+	if (g.Construct(def_windowW, def_windowH, 1, 1, false, true) == olc::rcode::OK)
 	{
 		g.Start();
 	}
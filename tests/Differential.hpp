@@ -0,0 +1,471 @@
+#ifndef LIFE_TESTS_DIFFERENTIAL_HPP
+#define LIFE_TESTS_DIFFERENTIAL_HPP
+
+#include <Checkpoint.hpp>
+#include <Distributed.hpp>
+#include <Generation.hpp>
+#include <Kernels.hpp>
+#include <Random.hpp>
+#include <Rendering.hpp>
+#include <SharedWorld.hpp>
+#include <Simulation.hpp>
+#include <Stream.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+
+namespace life::test
+{
+    // Where a kernel first disagreed with the oracle.
+    struct Divergence
+    {
+        std::string kernel;
+        uint64_t generation{};
+        uint64_t x{};
+        uint64_t y{};
+        int expected{};
+        int got{};
+        bool age = false;
+
+        // Set instead when the run failed before anything could be compared.
+        std::string failure;
+
+        [[nodiscard]] std::string describe() const
+        {
+            if (!failure.empty()) { return fmt::format("{}: {}", kernel, failure); }
+
+            return fmt::format("{} diverged at generation {}, cell ({}, {}): {} {} expected, got {}",
+                kernel, generation, x, y, age ? "age" : "state", expected, got);
+        }
+    };
+
+    /*
+        The oracle every kernel is held to: Simulation::countNeighbors() for every cell, and
+        the ages updated as Simulation's reference kernel does. Slow, but simple enough to trust.
+    */
+    class Oracle
+    {
+    public:
+        Oracle(uint64_t width, uint64_t height) : _width(width), _height(height), _simulation(width, height, 1u) {}
+
+        void step(const Generation& from, Generation& to) const
+        {
+            to.cells.resize(from.cells.size());
+            to.ages.resize(from.ages.size());
+            to.number = from.number + 1u;
+
+            for (auto y = 0uz; y < _height; ++y)
+            {
+                for (auto x = 0uz; x < _width; ++x)
+                {
+                    const auto index = (y * _width) + x;
+                    const auto neighbors = _simulation.countNeighbors(from.cells, x, y);
+                    const bool alive = (from.cells[index] == CellState::Alive) ? (neighbors == 2u || neighbors == 3u) : (neighbors == 3u);
+
+                    to.cells[index] = alive ? CellState::Alive : CellState::Dead;
+
+                    if (!from.ages.empty())
+                    {
+                        to.ages[index] = (to.cells[index] == from.cells[index]) ? static_cast<uint8_t>(std::min(from.ages[index], uint8_t{254}) + 1u) : uint8_t{};
+                    }
+                }
+            }
+        }
+
+    private:
+        uint64_t _width;
+        uint64_t _height;
+        Simulation _simulation;
+    };
+
+    // Compares cells, and ages where both sides have them.
+    inline std::optional<Divergence> firstDifference(std::string_view kernel, const Generation& expected, const auto& got, uint64_t width)
+    {
+        for (auto i = 0uz; i < expected.cells.size(); ++i)
+        {
+            if (expected.cells[i] != got.cells[i])
+            {
+                return Divergence{ .kernel=std::string{ kernel }, .generation=expected.number, .x=i % width, .y=i / width,
+                    .expected=static_cast<int>(expected.cells[i]), .got=static_cast<int>(got.cells[i]), .age=false, .failure={} };
+            }
+        }
+
+        for (auto i = 0uz; i < std::min(expected.ages.size(), got.ages.size()); ++i)
+        {
+            if (expected.ages[i] != got.ages[i])
+            {
+                return Divergence{ .kernel=std::string{ kernel }, .generation=expected.number, .x=i % width, .y=i / width,
+                    .expected=expected.ages[i], .got=got.ages[i], .age=true, .failure={} };
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    // How the kernels under test are set up. The world is split into bands like the workers split it.
+    struct KernelParameters
+    {
+        uint64_t tileWidth = 64u;
+        uint64_t temporalGenerations = 3u;
+        uint64_t temporalTile = 16u;
+        uint64_t bands = 3u;
+    };
+
+    inline std::vector<std::pair<uint64_t, uint64_t>> splitRows(uint64_t height, uint64_t bands)
+    {
+        bands = std::clamp(bands, uint64_t{1}, std::max(height, uint64_t{1}));
+
+        std::vector<std::pair<uint64_t, uint64_t>> rows;
+        for (auto i = 0uz; i < bands; ++i)
+        {
+            rows.emplace_back((height * i) / bands, (height * (i + 1u)) / bands);
+        }
+
+        return rows;
+    }
+
+    /*
+        Steps the tiled kernel, with and without ages, and the temporal kernel alongside the
+        oracle for the given number of generations. Every generation is compared, except that
+        the temporal kernel is compared after each of its passes.
+    */
+    inline std::optional<Divergence> checkKernels(const Generation& start, uint64_t width, uint64_t height, uint64_t generations, const KernelParameters& parameters)
+    {
+        const Oracle oracle{ width, height };
+        const auto bands = splitRows(height, parameters.bands);
+        const auto passLength = std::clamp(parameters.temporalGenerations, uint64_t{1}, maxGenerationsPerPass);
+
+        // Starts empty and grows on the first pass, then is reused like a worker's.
+        TemporalScratch scratch;
+
+        Generation expected{ .cells=start.cells, .ages=AgeBuffer(start.cells.size(), uint8_t{}), .number=0u };
+        Generation tiled{ .cells=start.cells, .ages={}, .number=0u };
+        Generation aged{ .cells=start.cells, .ages=AgeBuffer(start.cells.size(), uint8_t{}), .number=0u };
+        Generation temporal{ .cells=start.cells, .ages={}, .number=0u };
+        Generation next;
+
+        for (auto generation = 1uz; generation <= generations; ++generation)
+        {
+            oracle.step(expected, next);
+            std::swap(expected, next);
+
+            next = Generation{ .cells=CellBuffer(tiled.cells.size()), .ages={}, .number=generation };
+            for (const auto& [firstRow, lastRow] : bands) { stepTiled<false>(tiled, next, width, height, firstRow, lastRow, parameters.tileWidth); }
+            std::swap(tiled, next);
+
+            if (auto divergence = firstDifference(fmt::format("tiled kernel (tile width {})", parameters.tileWidth), expected, tiled, width)) { return divergence; }
+
+            next = Generation{ .cells=CellBuffer(aged.cells.size()), .ages=AgeBuffer(aged.ages.size()), .number=generation };
+            for (const auto& [firstRow, lastRow] : bands) { stepTiled<true>(aged, next, width, height, firstRow, lastRow, parameters.tileWidth); }
+            std::swap(aged, next);
+
+            if (auto divergence = firstDifference(fmt::format("tiled kernel with ages (tile width {})", parameters.tileWidth), expected, aged, width)) { return divergence; }
+
+            if (generation % passLength == 0u)
+            {
+                next = Generation{ .cells=CellBuffer(temporal.cells.size()), .ages={}, .number=generation };
+                for (const auto& [firstRow, lastRow] : bands) { stepTemporal(temporal, next, width, height, firstRow, lastRow, passLength, parameters.temporalTile, scratch); }
+                std::swap(temporal, next);
+
+                const Generation withoutAges{ .cells=expected.cells, .ages={}, .number=generation };
+                if (auto divergence = firstDifference(fmt::format("temporal kernel ({} generations, tile {})", passLength, parameters.temporalTile), withoutAges, temporal, width)) { return divergence; }
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    /*
+        Runs the whole engine, worker threads and all, from the given world and checks every
+        published generation against the oracle from the completion hook, while the workers
+        wait at the barrier.
+    */
+    inline std::optional<Divergence> checkSimulation(std::string_view name, const Generation& start, uint64_t width, uint64_t height,
+        uint64_t generations, std::size_t threads, const SimulationSettings& settings)
+    {
+        Simulation simulation{ width, height, threads, settings };
+        simulation.restore(start);
+
+        const Oracle oracle{ width, height };
+        Generation expected{ .cells=start.cells, .ages=AgeBuffer(simulation.tracksAges() ? start.cells.size() : 0u, uint8_t{}), .number=start.number };
+        Generation next;
+
+        std::optional<Divergence> divergence;
+        std::atomic<bool> done = false;
+
+        simulation.setCompletionHook([&](const Generation& published)
+        {
+            if (done) { return; }
+
+            while (expected.number < published.number)
+            {
+                oracle.step(expected, next);
+                std::swap(expected, next);
+            }
+
+            divergence = firstDifference(name, expected, published, width);
+
+            if (divergence || published.number >= generations)
+            {
+                done = true;
+                done.notify_all();
+            }
+        });
+
+        simulation.start();
+        done.wait(false);
+        simulation.stop();
+
+        return divergence;
+    }
+
+    // The engine pulled through streamGenerations(), stopping part way to check that it lets go of the workers.
+    inline std::optional<Divergence> checkStream(std::string_view name, const Generation& start, uint64_t width, uint64_t height,
+        uint64_t generations, uint64_t every, std::size_t threads, const SimulationSettings& settings)
+    {
+        Simulation simulation{ width, height, threads, settings };
+        simulation.restore(start);
+
+        const Oracle oracle{ width, height };
+        Generation expected{ .cells=start.cells, .ages=AgeBuffer(simulation.tracksAges() ? start.cells.size() : 0u, uint8_t{}), .number=start.number };
+        Generation next;
+
+        uint64_t previous = 0u;
+        bool first = true;
+
+        for (const auto& view : streamGenerations(simulation, every))
+        {
+            if (!first && view.number < previous + every)
+            {
+                return Divergence{ .kernel=std::string{ name }, .generation=view.number, .x=0u, .y=0u,
+                    .expected=static_cast<int>(previous + every), .got=static_cast<int>(view.number), .age=false, .failure={} };
+            }
+
+            while (expected.number < view.number)
+            {
+                oracle.step(expected, next);
+                std::swap(expected, next);
+            }
+
+            if (auto divergence = firstDifference(name, expected, view, width)) { return divergence; }
+            if (view.number >= generations) { break; }
+
+            previous = view.number;
+            first = false;
+        }
+
+        return std::nullopt;
+    }
+
+    inline Generation randomWorld(uint64_t width, uint64_t height, uint64_t seed, double density)
+    {
+        const CounterRng random{ seed };
+
+        Generation world{ .cells=CellBuffer(width * height), .ages={}, .number=0u };
+        for (auto i = 0uz; i < world.cells.size(); ++i)
+        {
+            world.cells[i] = random.chance(i, density) ? CellState::Alive : CellState::Dead;
+        }
+
+        return world;
+    }
+
+    /*
+        A headless run split over processes, saved as a checkpoint and compared with the oracle
+        run from the same seeded world. Needs fork(), like runDistributed() itself.
+    */
+    inline std::optional<Divergence> checkDistributed(std::string_view name, uint64_t width, uint64_t height, uint64_t generations, uint64_t processes, uint64_t seed)
+    {
+        const auto path = std::filesystem::temp_directory_path() / fmt::format("life-test-{}-{}.checkpoint", seed, processes);
+
+        Options options;
+        options.worldWidth = width;
+        options.worldHeight = height;
+        options.seed = seed;
+        options.density = 0.4;
+        options.processes = processes;
+        options.generations = generations;
+        options.outputPath = path.string();
+
+        const auto failed = [name](std::string_view reason)
+        {
+            return Divergence{ .kernel=std::string{ name }, .generation=0u, .x=0u, .y=0u, .expected=0, .got=0, .age=false, .failure=std::string{ reason } };
+        };
+
+        if (runDistributed(options) != 0) { return failed("the run failed"); }
+
+        auto saved = readCheckpoint(options.outputPath);
+        std::filesystem::remove(path);
+        if (saved.width != width || saved.height != height || saved.generation.number != generations) { return failed("wrong checkpoint header"); }
+
+        const Oracle oracle{ width, height };
+        auto expected = randomWorld(width, height, seed, options.density);
+        Generation next;
+
+        while (expected.number < generations)
+        {
+            oracle.step(expected, next);
+            std::swap(expected, next);
+        }
+
+        return firstDifference(name, expected, saved.generation, width);
+    }
+
+    /*
+        The engine computing straight into a shared-memory segment, each published generation
+        read back through a view of the segment, as another process would, and compared with
+        the oracle. Needs POSIX shared memory, like SharedWorld itself.
+    */
+    inline std::optional<Divergence> checkShared(std::string_view name, const Generation& start, uint64_t width, uint64_t height,
+        uint64_t generations, std::size_t threads)
+    {
+        SharedWorld shared{ fmt::format("life-test-{}x{}-{}", width, height, threads), width, height };
+        Simulation simulation{ width, height, threads, SimulationSettings{ .frameCells=shared.cells() } };
+        simulation.restore(start);
+        shared.publish(simulation.completed(), simulation.next());
+
+        const SharedWorldView view{ shared.name() };
+        const Oracle oracle{ width, height };
+        Generation expected{ .cells=start.cells, .ages={}, .number=start.number };
+        Generation next, seen{ .cells=CellBuffer(width * height), .ages={}, .number=0u };
+
+        std::optional<Divergence> divergence;
+        std::atomic<bool> done = false;
+
+        simulation.setCompletionHook([&](const Generation& published)
+        {
+            if (done) { return; }
+
+            shared.publish(published, simulation.next());
+
+            while (expected.number < published.number)
+            {
+                oracle.step(expected, next);
+                std::swap(expected, next);
+            }
+
+            // The workers are waiting at the barrier, so the copy can't be overtaken.
+            if (!view.snapshot(seen.cells, seen.number) || seen.number != published.number)
+            {
+                divergence = Divergence{ .kernel=std::string{ name }, .generation=published.number, .x=0u, .y=0u, .expected=0, .got=0, .age=false, .failure="the segment doesn't hold the published generation" };
+            }
+            else
+            {
+                divergence = firstDifference(name, expected, seen, width);
+            }
+
+            if (divergence || published.number >= generations)
+            {
+                done = true;
+                done.notify_all();
+            }
+        });
+
+        simulation.start();
+        done.wait(false);
+        simulation.stop();
+
+        return divergence;
+    }
+
+    /*
+        The window's renderer, which repaints only the cells that flipped: every frame must match
+        one painted in full. The first frame is painted by age, as with the heatmap on, so the
+        frames after it are painted right after the colouring changed.
+    */
+    inline std::optional<Divergence> checkRepaint(std::string_view name, const Generation& start, uint64_t width, uint64_t height, uint64_t generations, uint64_t magnify)
+    {
+        constexpr uint32_t alive = 0xFFFFFFFFu, dead = 0xFF000000u;
+
+        // Beyond the world's right and bottom edges as well.
+        const auto screenWidth = (width * magnify) + 3u;
+        const auto screenHeight = (height * magnify) + 2u;
+        const CellRect view{ .x=0u, .y=0u, .w=width, .h=height };
+
+        std::vector<uint64_t> rows(height);
+        std::iota(rows.begin(), rows.end(), uint64_t{});
+
+        // No age colour is the plain colour of either state.
+        std::vector<uint32_t> palette(512u);
+        std::iota(palette.begin(), palette.end(), 0xFF102030u);
+
+        const CellColours plain{ .alive=alive, .dead=dead, .palette={} };
+        const CellColours byAge{ .alive=alive, .dead=dead, .palette=palette };
+
+        std::vector<uint32_t> pixels(screenWidth * screenHeight), expected(pixels.size());
+        ShownCells shown{ .cells=std::vector<CellState>(pixels.size()), .valid=false, .byAge=false };
+
+        const Oracle oracle{ width, height };
+        Generation current{ .cells=start.cells, .ages=AgeBuffer(start.cells.size(), uint8_t{7}), .number=start.number };
+        Generation next;
+
+        paintCells(current, width, view, magnify, byAge, rows, pixels, screenWidth, shown, false);
+
+        const auto failed = [name, screenWidth](uint64_t generation, std::size_t pixel, std::string_view reason)
+        {
+            return Divergence{ .kernel=std::string{ name }, .generation=generation, .x=pixel % screenWidth, .y=pixel / screenWidth,
+                .expected=0, .got=0, .age=false, .failure=fmt::format("generation {}, pixel ({}, {}) {}", generation, pixel % screenWidth, pixel / screenWidth, reason) };
+        };
+
+        for (auto generation = 0uz; generation < generations; ++generation)
+        {
+            paintCells(current, width, view, magnify, plain, rows, pixels, screenWidth, shown, true);
+
+            if (const auto stale = std::ranges::find_if(pixels, [](uint32_t pixel) { return pixel != alive && pixel != dead; }); stale != pixels.end())
+            {
+                return failed(current.number, static_cast<std::size_t>(stale - pixels.begin()), "still has its age colour");
+            }
+
+            ShownCells fresh{ .cells=std::vector<CellState>(pixels.size()), .valid=false, .byAge=false };
+            paintCells(current, width, view, magnify, plain, rows, expected, screenWidth, fresh, false);
+
+            if (const auto [got, want] = std::ranges::mismatch(pixels, expected); got != pixels.end())
+            {
+                return failed(current.number, static_cast<std::size_t>(got - pixels.begin()), "differs from a full repaint");
+            }
+
+            oracle.step(current, next);
+            std::swap(current, next);
+        }
+
+        return std::nullopt;
+    }
+
+    /*
+        The fuzzer's view of an input: the first bytes pick the world's size, how long to run
+        and how the kernels are set up, the rest are the world's cells, one bit each.
+    */
+    inline std::optional<Divergence> checkInput(std::span<const uint8_t> input)
+    {
+        if (input.size() < 6u) { return std::nullopt; }
+
+        const uint64_t width = 1u + (input[0] % 80u);
+        const uint64_t height = 1u + (input[1] % 80u);
+        const uint64_t generations = 1u + (input[2] % 24u);
+
+        const KernelParameters parameters{ .tileWidth=1u + (input[3] % 96u), .temporalGenerations=1u + (input[4] % 6u),
+            .temporalTile=1u + (input[5] % 20u), .bands=1u + (input[4] / 6u % 4u) };
+
+        const auto bits = input.subspan(6u);
+
+        Generation start{ .cells=CellBuffer(width * height), .ages={}, .number=0u };
+        for (auto i = 0uz; i < start.cells.size(); ++i)
+        {
+            const bool alive = !bits.empty() && ((static_cast<unsigned>(bits[(i / 8u) % bits.size()]) >> (i % 8u)) & 1u) != 0u;
+            start.cells[i] = alive ? CellState::Alive : CellState::Dead;
+        }
+
+        return checkKernels(start, width, height, generations, parameters);
+    }
+}
+
+#endif
@@ -0,0 +1,23 @@
+#include <Differential.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <fmt/format.h>
+
+/*
+	libFuzzer entry point: each input is a world and a kernel setup, see life::test::checkInput().
+	Any difference from the oracle aborts, so the fuzzer keeps the input that found it.
+
+		kernel_fuzz -max_total_time=600 corpus/
+*/
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, std::size_t size)
+{
+	if (const auto divergence = life::test::checkInput(std::span<const uint8_t>{ data, size }))
+	{
+		fmt::println(stderr, "{}", divergence->describe());
+		std::abort();
+	}
+
+	return 0;
+}
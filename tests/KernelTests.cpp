@@ -0,0 +1,322 @@
+#include <Differential.hpp>
+#include <Census.hpp>
+#include <array>
+#include <cstdlib>
+#include <cstdio>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+
+/*
+	Differential tests: every kernel, and the engine running each of them on worker threads,
+	against the countNeighbors() oracle. Stops at the first cell that differs.
+*/
+
+namespace
+{
+	using namespace life;
+	using namespace life::test;
+
+	// Rows of '#' and '.', stamped into the world with their top left corner at (left, top).
+	void place(Generation& world, uint64_t width, uint64_t height, std::span<const std::string_view> pattern, uint64_t left, uint64_t top)
+	{
+		auto y = top;
+		for (const auto row : pattern)
+		{
+			for (auto x = 0uz; x < row.size(); ++x)
+			{
+				if (row[x] == '#' && left + x < width && y < height) { world.cells[(y * width) + left + x] = CellState::Alive; }
+			}
+			++y;
+		}
+	}
+
+	Generation stamp(uint64_t width, uint64_t height, std::span<const std::string_view> pattern, uint64_t left, uint64_t top)
+	{
+		Generation world{ .cells=CellBuffer(width * height, CellState::Dead), .ages={}, .number=0u };
+		place(world, width, height, pattern, left, top);
+		return world;
+	}
+
+	constexpr std::array<std::string_view, 2> block{ "##", "##" };
+	constexpr std::array<std::string_view, 3> beehive{ ".##.", "#..#", ".##." };
+	constexpr std::array<std::string_view, 1> blinker{ "###" };
+	constexpr std::array<std::string_view, 2> toad{ ".###", "###." };
+	constexpr std::array<std::string_view, 4> beacon{ "##..", "##..", "..##", "..##" };
+	constexpr std::array<std::string_view, 13> pulsar
+	{
+		"..###...###..",
+		".............",
+		"#....#.#....#",
+		"#....#.#....#",
+		"#....#.#....#",
+		"..###...###..",
+		".............",
+		"..###...###..",
+		"#....#.#....#",
+		"#....#.#....#",
+		"#....#.#....#",
+		".............",
+		"..###...###..",
+	};
+	constexpr std::array<std::string_view, 3> glider{ ".#.", "..#", "###" };
+	constexpr std::array<std::string_view, 4> lightweightSpaceship{ "#..#.", "....#", "#...#", ".####" };
+
+	struct Case
+	{
+		std::string name;
+		std::function<std::optional<Divergence>()> run;
+	};
+
+	// The oracle itself has to get the textbook patterns right before it can judge anything.
+	std::optional<std::string> checkOracle()
+	{
+		const auto advance = [](Generation world, uint64_t width, uint64_t height, uint64_t generations)
+		{
+			const Oracle oracle{ width, height };
+			Generation next;
+			for (auto i = 0uz; i < generations; ++i)
+			{
+				oracle.step(world, next);
+				std::swap(world, next);
+			}
+			return world;
+		};
+
+		struct Oscillator { std::string_view name; std::span<const std::string_view> pattern; uint64_t period; };
+		for (const auto& [name, pattern, period] : std::array{ Oscillator{ "blinker", blinker, 2u }, Oscillator{ "toad", toad, 2u },
+			Oscillator{ "beacon", beacon, 2u }, Oscillator{ "pulsar", pulsar, 3u } })
+		{
+			const auto start = stamp(24u, 24u, pattern, 5u, 5u);
+			if (advance(start, 24u, 24u, 1u).cells == start.cells) { return fmt::format("the oracle keeps the {} still", name); }
+			if (advance(start, 24u, 24u, period).cells != start.cells) { return fmt::format("the oracle doesn't bring the {} back after {} generations", name, period); }
+		}
+
+		// Both move one cell diagonally or two cells across every four generations.
+		if (advance(stamp(20u, 20u, glider, 2u, 2u), 20u, 20u, 4u).cells != stamp(20u, 20u, glider, 3u, 3u).cells)
+		{
+			return std::string{ "the oracle doesn't move the glider" };
+		}
+
+		if (advance(stamp(24u, 12u, lightweightSpaceship, 4u, 4u), 24u, 12u, 4u).cells != stamp(24u, 12u, lightweightSpaceship, 6u, 4u).cells)
+		{
+			return std::string{ "the oracle doesn't move the lightweight spaceship" };
+		}
+
+		return std::nullopt;
+	}
+
+	/*
+		The census of known still lifes, oscillators and gliders, split into bands. With four
+		bands the boundaries fall on rows 10, 20 and 30, and the second block, beehive, beacon
+		and glider straddle them, so they are only counted right if the bands are stitched.
+	*/
+	std::optional<Divergence> checkCensus(std::size_t bands)
+	{
+		constexpr auto width = 48u, height = 40u;
+
+		auto world = stamp(width, height, block, 2u, 2u);
+		place(world, width, height, beehive, 10u, 2u);
+		place(world, width, height, blinker, 20u, 2u);
+		place(world, width, height, toad, 30u, 2u);
+		place(world, width, height, glider, 40u, 2u);
+		place(world, width, height, block, 2u, 9u);
+		place(world, width, height, beehive, 10u, 19u);
+		place(world, width, height, beacon, 20u, 28u);
+		place(world, width, height, glider, 40u, 29u);
+
+		struct Expected { std::string_view code; std::string_view name; uint64_t count; };
+		constexpr std::array<Expected, 6> expected
+		{{
+			{ "xq4_153", "glider", 2u }, { "xs4_33", "block", 2u }, { "xs6_696", "beehive", 2u },
+			{ "xp2_318c", "", 1u }, { "xp2_7", "blinker", 1u }, { "xp2_7e", "", 1u },
+		}};
+
+		const auto name = fmt::format("census in {} bands", bands);
+		const auto failed = [&name](std::string reason)
+		{
+			return Divergence{ .kernel=name, .generation=0u, .x=0u, .y=0u, .expected=0, .got=0, .age=false, .failure=std::move(reason) };
+		};
+
+		const auto census = takeCensus(world.cells, width, height, bands);
+
+		if (census.objects != 9u || census.population != 47u || census.oversized != 0u)
+		{
+			return failed(fmt::format("{} objects of {} cells, {} too large, expected 9 of 47, none too large", census.objects, census.population, census.oversized));
+		}
+
+		if (census.entries.size() != expected.size()) { return failed(fmt::format("{} kinds of object, expected {}", census.entries.size(), expected.size())); }
+
+		// Ties are listed by code.
+		for (auto i = 0uz; i < expected.size(); ++i)
+		{
+			const auto& entry = census.entries[i];
+			if (entry.code != expected[i].code || entry.name != expected[i].name || entry.count != expected[i].count)
+			{
+				return failed(fmt::format("entry {} is {} x{} '{}', expected {} x{} '{}'", i, entry.code, entry.count, entry.name, expected[i].code, expected[i].count, expected[i].name));
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	std::vector<Case> cases()
+	{
+		std::vector<Case> all;
+
+		const auto kernels = [&all](std::string name, Generation start, uint64_t width, uint64_t height, uint64_t generations, KernelParameters parameters = {})
+		{
+			all.push_back(Case{ .name=std::move(name), .run=[=](){ return checkKernels(start, width, height, generations, parameters); } });
+		};
+
+		// Odd sizes, including those just around the 32-cell blocks and the tile widths.
+		constexpr std::array<std::pair<uint64_t, uint64_t>, 14> sizes
+		{{
+			{ 1u, 1u }, { 1u, 9u }, { 9u, 1u }, { 2u, 2u }, { 3u, 5u }, { 17u, 13u }, { 31u, 33u },
+			{ 33u, 31u }, { 63u, 65u }, { 65u, 63u }, { 127u, 31u }, { 129u, 7u }, { 200u, 3u }, { 301u, 97u },
+		}};
+
+		for (const auto& [width, height] : sizes)
+		{
+			const auto generations = (width * height <= 4096u) ? 3000u : 1000u;
+
+			for (const auto density : { 0.2, 0.5 })
+			{
+				kernels(fmt::format("random {}x{} at {}", width, height, density), randomWorld(width, height, width * 1000u + height, density), width, height, generations,
+					KernelParameters{ .tileWidth=32u + (width % 37u), .temporalGenerations=1u + (height % 5u), .temporalTile=4u + (width % 13u), .bands=1u + (width % 4u) });
+			}
+		}
+
+		// Tiles of every width up to a few blocks, so every remainder is hit.
+		for (auto tileWidth = 1uz; tileWidth <= 70uz; ++tileWidth)
+		{
+			kernels(fmt::format("random 151x23, tile width {}", tileWidth), randomWorld(151u, 23u, tileWidth, 0.4), 151u, 23u, 40u,
+				KernelParameters{ .tileWidth=tileWidth, .temporalGenerations=1u + (tileWidth % 8u), .temporalTile=tileWidth, .bands=1u + (tileWidth % 5u) });
+		}
+
+		// The deepest temporal blocking, on tiles smaller than their halo.
+		kernels("random 97x89, 64 generations per pass", randomWorld(97u, 89u, 64u, 0.35), 97u, 89u, 640u,
+			KernelParameters{ .tileWidth=64u, .temporalGenerations=maxGenerationsPerPass, .temporalTile=7u, .bands=4u });
+
+		kernels("oscillators", stamp(40u, 40u, pulsar, 2u, 2u), 40u, 40u, 3000u);
+		kernels("blinker, toad and beacon", [](){
+			auto world = stamp(30u, 12u, blinker, 2u, 2u);
+			const auto more = stamp(30u, 12u, toad, 10u, 2u), beacons = stamp(30u, 12u, beacon, 20u, 2u);
+			for (auto i = 0uz; i < world.cells.size(); ++i) { if (more.cells[i] == CellState::Alive || beacons.cells[i] == CellState::Alive) { world.cells[i] = CellState::Alive; } }
+			return world; }(), 30u, 12u, 3000u);
+
+		// Spaceships fly into the edges and crash there, so every boundary is crossed.
+		kernels("glider into the bottom right corner", stamp(48u, 37u, glider, 1u, 1u), 48u, 37u, 3000u);
+		kernels("glider across a band boundary", stamp(20u, 60u, glider, 2u, 15u), 20u, 60u, 3000u, KernelParameters{ .tileWidth=8u, .temporalGenerations=5u, .temporalTile=6u, .bands=5u });
+		kernels("spaceship into the right edge", stamp(70u, 10u, lightweightSpaceship, 3u, 3u), 70u, 10u, 3000u, KernelParameters{ .tileWidth=16u, .temporalGenerations=4u, .temporalTile=9u, .bands=2u });
+
+		// Live cells hugging every edge and corner.
+		kernels("border", [](){
+			Generation world{ .cells=CellBuffer(37u * 29u, CellState::Dead), .ages={}, .number=0u };
+			for (auto x = 0uz; x < 37u; ++x) { world.cells[x] = world.cells[(28u * 37u) + x] = CellState::Alive; }
+			for (auto y = 0uz; y < 29u; ++y) { world.cells[y * 37u] = world.cells[(y * 37u) + 36u] = CellState::Alive; }
+			return world; }(), 37u, 29u, 1000u);
+
+		kernels("all alive", Generation{ .cells=CellBuffer(45u * 45u, CellState::Alive), .ages={}, .number=0u }, 45u, 45u, 1000u);
+		kernels("all dead", Generation{ .cells=CellBuffer(45u * 45u, CellState::Dead), .ages={}, .number=0u }, 45u, 45u, 100u);
+
+		// Ages saturate at 255, which takes still lifes a few hundred generations to reach.
+		kernels("aged still lifes", stamp(16u, 16u, std::array<std::string_view, 4>{ "##....", "##....", "....##", "....##" }, 4u, 4u), 16u, 16u, 600u);
+
+		// The engine, on worker threads, for every kernel and mode.
+		const auto engine = [&all](std::string name, uint64_t width, uint64_t height, uint64_t generations, std::size_t threads, SimulationSettings settings)
+		{
+			all.push_back(Case{ .name=name, .run=[=](){ return checkSimulation(name, randomWorld(width, height, generations, 0.4), width, height, generations, threads, settings); } });
+		};
+
+		engine("simulation, reference kernel with ages", 83u, 61u, 500u, 4u, SimulationSettings{ .trackAges=true, .kernel=Kernel::Reference });
+		engine("simulation, tiled kernel", 83u, 61u, 1000u, 4u, SimulationSettings{ .kernel=Kernel::Tiled, .tileWidth=40u });
+		engine("simulation, tiled kernel with ages", 83u, 61u, 1000u, 3u, SimulationSettings{ .trackAges=true, .kernel=Kernel::Tiled });
+		engine("simulation, temporal kernel", 83u, 61u, 1002u, 4u, SimulationSettings{ .kernel=Kernel::Tiled, .generationsPerPass=3u });
+		engine("simulation, rebalancing every pass", 83u, 61u, 1000u, 4u, SimulationSettings{ .kernel=Kernel::Tiled, .rebalanceEvery=1u });
+		engine("simulation, more workers than fit", 19u, 3u, 300u, 4u, SimulationSettings{ .kernel=Kernel::Tiled });
+
+		// The engine pulled as a stream of views, every generation and every few.
+		const auto stream = [&all](std::string name, uint64_t generations, uint64_t every, SimulationSettings settings)
+		{
+			all.push_back(Case{ .name=name, .run=[=](){ return checkStream(name, randomWorld(83u, 61u, generations, 0.4), 83u, 61u, generations, every, 4u, settings); } });
+		};
+
+		stream("stream, every generation", 300u, 1u, SimulationSettings{ .kernel=Kernel::Tiled });
+		stream("stream, every 7th generation with ages", 700u, 7u, SimulationSettings{ .trackAges=true, .kernel=Kernel::Tiled });
+		stream("stream, every 5th of the temporal kernel", 600u, 5u, SimulationSettings{ .kernel=Kernel::Tiled, .generationsPerPass=3u });
+
+#if defined(__unix__) || defined(__APPLE__)
+		// Headless runs split over processes, down to a single row each.
+		const auto distributed = [&all](std::string name, uint64_t width, uint64_t height, uint64_t generations, uint64_t processes)
+		{
+			all.push_back(Case{ .name=name, .run=[=](){ return checkDistributed(name, width, height, generations, processes, width * height + processes); } });
+		};
+
+		distributed("distributed, one process", 61u, 47u, 300u, 1u);
+		distributed("distributed, two processes", 61u, 47u, 300u, 2u);
+		distributed("distributed, uneven bands", 61u, 47u, 300u, 7u);
+		distributed("distributed, a row per process", 37u, 5u, 200u, 5u);
+
+		// The engine computing in a shared-memory segment, read back as another process would.
+		const auto shared = [&all](std::string name, uint64_t width, uint64_t height, uint64_t generations, std::size_t threads)
+		{
+			all.push_back(Case{ .name=name, .run=[=](){ return checkShared(name, randomWorld(width, height, generations, 0.4), width, height, generations, threads); } });
+		};
+
+		shared("shared, one worker", 83u, 61u, 200u, 1u);
+		shared("shared, four workers", 83u, 61u, 200u, 4u);
+#endif
+
+		// The window repainting only the cells that flipped, after the heatmap was switched off.
+		for (const auto magnify : { 1u, 3u })
+		{
+			all.push_back(Case{ .name=fmt::format("repaint, magnified {}x", magnify), .run=[magnify]()
+			{
+				return checkRepaint(fmt::format("repaint, magnified {}x", magnify), randomWorld(37u, 29u, magnify, 0.4), 37u, 29u, 100u, magnify);
+			} });
+		}
+
+		for (const auto bands : { 1uz, 4uz, 40uz })
+		{
+			all.push_back(Case{ .name=fmt::format("census in {} bands", bands), .run=[bands](){ return checkCensus(bands); } });
+		}
+
+		// Random fuzzer inputs, so the fuzz entry point is exercised even without a fuzzer.
+		for (auto seed = 0uz; seed < 300uz; ++seed)
+		{
+			const CounterRng random{ seed };
+			std::vector<uint8_t> input(6uz + (seed % 400uz));
+			for (auto i = 0uz; i < input.size(); ++i) { input[i] = static_cast<uint8_t>(random(i)); }
+
+			all.push_back(Case{ .name=fmt::format("fuzz input {}", seed), .run=[input](){ return checkInput(input); } });
+		}
+
+		return all;
+	}
+}
+
+int main()
+{
+	if (const auto failure = checkOracle())
+	{
+		fmt::println(stderr, "FAILED: {}", *failure);
+		return EXIT_FAILURE;
+	}
+
+	const auto all = cases();
+
+	for (const auto& test : all)
+	{
+		if (const auto divergence = test.run())
+		{
+			fmt::println(stderr, "FAILED {}: {}", test.name, divergence->describe());
+			return EXIT_FAILURE;
+		}
+	}
+
+	fmt::println(stdout, "All {} cases agree with the oracle", all.size());
+	return EXIT_SUCCESS;
+}